@@ -32,6 +32,13 @@
 #include <libbuild2/file-cache.hxx>
 #include <libbuild2/diagnostics.hxx>
 #include <libbuild2/prerequisite.hxx>
+#include <libbuild2/timeline.hxx>
+#include <libbuild2/jobserver.hxx>
+#include <libbuild2/diag-reactor.hxx>
+#include <libbuild2/worker-pool.hxx>
+#include <libbuild2/action-cache.hxx>
+#include <libbuild2/memory-arena.hxx>
+#include <libbuild2/target-durations.hxx>
 
 #include <libbuild2/parser.hxx>
 
@@ -258,6 +265,34 @@ main (int argc, char* argv[])
   // Statistics.
   //
   size_t phase_switch_contention (0);
+  size_t variable_cache_contention (0);
+  size_t target_arena_allocated (0);
+
+  // Target execution durations (see --critical-path).
+  //
+  optional<target_durations> durations;
+
+  // Build timeline (see --trace).
+  //
+  optional<timeline> tline;
+
+  // GNU make jobserver (see --jobserver). Must outlive the scheduler
+  // session.
+  //
+  optional<jobserver> jserver;
+
+  // Child process diagnostics reactor (see --diag-reactor). Must outlive
+  // the build contexts.
+  //
+  optional<diag_reactor> reactor;
+
+  // Local worker pool (see --worker-pool). Must outlive the build contexts.
+  //
+  optional<worker_pool> wpool;
+
+  // Action cache (see --action-cache). Must outlive the build contexts.
+  //
+  optional<action_cache> acache;
 
   try
   {
@@ -356,6 +391,14 @@ main (int argc, char* argv[])
           cmdl.config_sub,
           cmdl.config_guess);
 
+    // Run as the worker pool daemon (see --worker-serve).
+    //
+    if (ops.worker_serve_specified ())
+    {
+      worker_serve (ops.worker_serve (), cmdl.jobs);
+      return 0;
+    }
+
     // Load builtin modules.
     //
     load_builtin_module (&config::build2_config_load);
@@ -383,9 +426,82 @@ main (int argc, char* argv[])
                    cmdl.jobs * ops.queue_depth (),
                    cmdl.max_stack);
 
+    if (ops.futex_wait ())
+      sched.use_futex ();
+
+    // Connect to or create the jobserver.
+    //
+    {
+      string m (ops.jobserver_specified ()
+                ? ops.jobserver ()
+                : ops.jobs_specified () ? "none" : "client");
+
+      if (m != "client" && m != "server" && m != "none")
+        fail << "invalid --jobserver value '" << m << "'";
+
+      if (m != "none")
+      {
+        jserver.emplace ();
+
+        if (jserver->connect ())
+          sched.use_jobserver (*jserver);
+        else if (m == "server")
+        {
+          jserver->create (cmdl.jobs);
+          sched.use_jobserver (*jserver);
+        }
+        else
+          jserver = nullopt;
+      }
+    }
+
     global_mutexes mutexes (sched.shard_size ());
     file_cache fcache (cmdl.fcache_compress);
 
+    // Note that we only track the durations if requested with
+    // --critical-path (rather than also for --stat) since that costs a
+    // system_clock::now() call for each executed target.
+    //
+    if (ops.critical_path_specified ())
+    {
+      durations.emplace ();
+      durations->load (ops.critical_path ());
+    }
+
+    // Note that without buffering (serial or --no-diag-buffer) there is
+    // nothing for the reactor to do.
+    //
+    if (ops.diag_reactor () && !sched.serial () && !ops.no_diag_buffer ())
+      reactor.emplace ();
+
+    if (ops.worker_pool_specified ())
+      wpool.emplace (ops.worker_pool ());
+
+    if (ops.action_cache_specified ())
+    {
+      dir_path d (ops.action_cache ());
+
+      try
+      {
+        d.complete ().normalize ();
+      }
+      catch (const invalid_path& e)
+      {
+        fail << "invalid --action-cache directory '" << e.path << "'";
+      }
+
+      acache.emplace (move (d));
+    }
+
+    if (ops.trace_specified ())
+    {
+#ifdef BUILD2_BOOTSTRAP
+      fail << "trace not supported in bootstrap build system";
+#endif
+      tline.emplace (ops.trace ());
+      build_timeline = &*tline;
+    }
+
     // Trace some overall environment information.
     //
     if (verb >= 5)
@@ -407,12 +523,21 @@ main (int argc, char* argv[])
     auto new_context = [&ops, &cmdl,
                         &sched, &mutexes, &fcache,
                         &phase_switch_contention,
+                        &target_arena_allocated,
+                        &durations,
+                        &reactor,
+                        &wpool,
+                        &acache,
                         &pctx]
     {
       if (pctx != nullptr)
       {
         phase_switch_contention += (pctx->phase_mutex.contention +
                                     pctx->phase_mutex.contention_load);
+
+        if (pctx->arena != nullptr)
+          target_arena_allocated += pctx->arena->allocated ();
+
         pctx = nullptr; // Free first to reuse memory.
       }
 
@@ -435,6 +560,21 @@ main (int argc, char* argv[])
 
       if (ops.trace_execute_specified ())
         pctx->trace_execute = &ops.trace_execute ();
+
+      if (durations)
+        pctx->durations = &*durations;
+
+      if (reactor)
+        pctx->reactor = &*reactor;
+
+      if (wpool)
+        pctx->workers = &*wpool;
+
+      if (acache)
+        pctx->acache = &*acache;
+
+      if (ops.target_arena ())
+        pctx->arena.reset (new memory_arena);
     };
 
     new_context ();
@@ -1658,6 +1798,25 @@ main (int argc, char* argv[])
 
     phase_switch_contention += (pctx->phase_mutex.contention +
                                 pctx->phase_mutex.contention_load);
+
+    if (pctx->arena != nullptr)
+      target_arena_allocated += pctx->arena->allocated ();
+
+    variable_cache_contention = mutexes.variable_cache_contention ();
+
+    // In the fast exit mode leak the build state, including any nested
+    // module contexts, instead of destroying it (see --fast-exit for
+    // details). Note that the context destructor writes the remaining
+    // timeline events so we have to do it ourselves. Note also that we only
+    // get here if the build succeeded.
+    //
+    if (ops.fast_exit ())
+    {
+      if (build_timeline != nullptr)
+        build_timeline->flush ();
+
+      pctx.release ();
+    }
   }
   catch (const failed&)
   {
@@ -1675,6 +1834,21 @@ main (int argc, char* argv[])
   //
   assert (st.task_queue_remain == 0);
 
+  // Save the target execution durations, including in case of a failure
+  // (the durations of what was executed are still valid).
+  //
+  if (durations)
+    durations->save (ops.critical_path ());
+
+  // Write the remaining timeline events (by now all the contexts have been
+  // destroyed and their events flushed), also in case of a failure.
+  //
+  if (tline)
+  {
+    tline->close ();
+    build_timeline = nullptr;
+  }
+
   if (ops.stat ())
   {
     text << '\n'
@@ -1690,7 +1864,24 @@ main (int argc, char* argv[])
          << "  wait_queue_slots        " << st.wait_queue_slots      << '\n'
          << "  wait_queue_collisions   " << st.wait_queue_collisions << '\n'
          << '\n'
-         << "  phase_switch_contention " << phase_switch_contention << '\n';
+         << "  phase_switch_contention " << phase_switch_contention << '\n'
+         << "  var_cache_contention    " << variable_cache_contention << '\n';
+
+    if (ops.target_arena ())
+      text << "  target_arena_allocated  " << target_arena_allocated << '\n';
+
+    if (durations)
+    {
+      auto ms = [] (duration d)
+      {
+        return chrono::duration_cast<chrono::milliseconds> (d).count ();
+      };
+
+      text << "  critical_path_predicted " << ms (durations->predicted_path ())
+           << "ms\n"
+           << "  critical_path_actual    " << ms (durations->actual_path ())
+           << "ms\n";
+    }
   }
 
   return r;
@@ -0,0 +1,260 @@
+// file      : libbuild2/action-cache.cxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#include <libbuild2/action-cache.hxx>
+
+#include <libbuild2/filesystem.hxx>  // mapped_file, file_exists(), etc
+#include <libbuild2/diagnostics.hxx>
+
+using namespace std;
+using namespace butl;
+
+namespace build2
+{
+  action_cache::
+  action_cache (dir_path r)
+      : root_ (move (r)),
+        ac_ (root_ / dir_path ("ac")),
+        cas_ (root_ / dir_path ("cas"))
+  {
+    try
+    {
+      try_mkdir_p (ac_);
+      try_mkdir_p (cas_);
+    }
+    catch (const system_error& e)
+    {
+      fail << "unable to create action cache directory " << root_ << ": "
+           << e;
+    }
+  }
+
+  string action_cache::
+  digest (const path& f, timestamp mt)
+  {
+    {
+      slock l (digests_mutex_);
+
+      auto i (digests_.find (f.string ()));
+      if (i != digests_.end () && i->second.mtime == mt)
+        return i->second.digest;
+    }
+
+    string r;
+    {
+      mapped_file mf (f);
+
+      sha256 cs;
+      cs.append (mf.data (), mf.size ());
+      r = cs.string ();
+    }
+
+    ulock l (digests_mutex_);
+    digests_[f.string ()] = digest_entry {mt, r};
+    return r;
+  }
+
+  path action_cache::
+  temp_path (const path& f)
+  {
+    static atomic<size_t> count (0);
+
+    return path (f.string () + '.' +
+                 to_string (process::current_id ()) + '.' +
+                 to_string (count.fetch_add (1, memory_order_relaxed)) +
+                 ".tmp");
+  }
+
+  bool action_cache::
+  fetch (const string& a, const paths& outs)
+  {
+    path af (ac_ / path (a));
+
+    // Read the action result. Note that the output sizes are only recorded
+    // for compatibility with the remote execution API digests.
+    //
+    vector<pair<string, uint64_t>> rs;
+    try
+    {
+      if (!file_exists (af))
+        return false;
+
+      ifdstream is (af, ifdstream::badbit);
+
+      for (string l; !eof (getline (is, l)); )
+      {
+        size_t p (l.find (' '));
+        if (p == string::npos)
+          throw invalid_argument ("no size");
+
+        rs.emplace_back (string (l, 0, p), stoull (string (l, p + 1)));
+      }
+
+      is.close ();
+    }
+    catch (const io_error& e)
+    {
+      warn << "unable to read " << af << ": " << e;
+      return false;
+    }
+    catch (const system_error& e)
+    {
+      warn << "unable to read " << af << ": " << e;
+      return false;
+    }
+    catch (const invalid_argument&)
+    {
+      warn << "invalid action cache entry " << af;
+      return false;
+    }
+    catch (const out_of_range&)
+    {
+      warn << "invalid action cache entry " << af;
+      return false;
+    }
+
+    if (rs.size () != outs.size ())
+    {
+      warn << "action cache entry " << af << " has " << rs.size ()
+           << " outputs instead of " << outs.size ();
+      return false;
+    }
+
+    // Download the outputs.
+    //
+    // We first copy each output into a temporary file next to its final
+    // location and verify its digest: the CAS entry could be corrupted (for
+    // example, truncated on a shared filesystem) and we don't want to end up
+    // with a bogus output that looks up to date. Only once all of them check
+    // out do we move them into place.
+    //
+    vector<auto_rmfile> tfs;
+    tfs.reserve (outs.size ());
+
+    for (size_t i (0); i != outs.size (); ++i)
+    {
+      path cf (cas_ / path (rs[i].first));
+      const path& o (outs[i]);
+
+      tfs.emplace_back (temp_path (o));
+      const path& tf (tfs.back ().path);
+
+      try
+      {
+        cpfile (cf, tf);
+
+        string d;
+        uint64_t n;
+        {
+          mapped_file mf (tf);
+
+          sha256 cs;
+          cs.append (mf.data (), mf.size ());
+          d = cs.string ();
+          n = mf.size ();
+        }
+
+        if (d != rs[i].first || n != rs[i].second)
+        {
+          warn << "corrupted action cache entry " << cf <<
+            info << "removing it";
+
+          try_rmfile (cf, true /* ignore_error */);
+          try_rmfile (af, true /* ignore_error */); // Let store() redo it.
+          return false;
+        }
+      }
+      catch (const system_error& e)
+      {
+        warn << "unable to copy " << cf << " to " << tf << ": " << e;
+
+        try_rmfile (af, true /* ignore_error */);
+        return false;
+      }
+    }
+
+    for (size_t i (0); i != outs.size (); ++i)
+    {
+      const path& o (outs[i]);
+      const path& tf (tfs[i].path);
+
+      try
+      {
+        mvfile (tf, o, cpflags::overwrite_content);
+        tfs[i].cancel ();
+      }
+      catch (const system_error& e)
+      {
+        warn << "unable to move " << tf << " to " << o << ": " << e;
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  void action_cache::
+  store (const string& a, const paths& outs)
+  {
+    path af (ac_ / path (a));
+
+    try
+    {
+      if (file_exists (af))
+        return;
+
+      // Upload the outputs and collect the result.
+      //
+      string r;
+      for (const path& o: outs)
+      {
+        string d;
+        uint64_t n;
+        {
+          mapped_file mf (o);
+
+          sha256 cs;
+          cs.append (mf.data (), mf.size ());
+          d = cs.string ();
+          n = mf.size ();
+        }
+
+        path cf (cas_ / path (d));
+
+        if (!file_exists (cf))
+        {
+          path tf (temp_path (cf));
+          auto_rmfile rm (tf);
+          cpfile (o, tf);
+          mvfile (tf, cf, cpflags::overwrite_content);
+          rm.cancel ();
+        }
+
+        r += d;
+        r += ' ';
+        r += to_string (n);
+        r += '\n';
+      }
+
+      // Record the result.
+      //
+      path tf (temp_path (af));
+      auto_rmfile rm (tf);
+      {
+        ofdstream os (tf);
+        os << r;
+        os.close ();
+      }
+      mvfile (tf, af, cpflags::overwrite_content);
+      rm.cancel ();
+    }
+    catch (const io_error& e)
+    {
+      warn << "unable to store action result in " << root_ << ": " << e;
+    }
+    catch (const system_error& e)
+    {
+      warn << "unable to store action result in " << root_ << ": " << e;
+    }
+  }
+}
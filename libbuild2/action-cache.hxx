@@ -0,0 +1,100 @@
+// file      : libbuild2/action-cache.hxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#ifndef LIBBUILD2_ACTION_CACHE_HXX
+#define LIBBUILD2_ACTION_CACHE_HXX
+
+#include <unordered_map>
+
+#include <libbuild2/types.hxx>
+#include <libbuild2/forward.hxx>
+#include <libbuild2/utility.hxx>
+
+#include <libbuild2/export.hxx>
+
+namespace build2
+{
+  // Content-addressed action cache (see the --action-cache option).
+  //
+  // Similar in spirit to the remote execution API action cache, an action
+  // (a recipe execution) is identified by its digest which is calculated by
+  // the rule from everything that affects its outputs: the command line or
+  // script, the environment, and the paths and content digests of all the
+  // inputs (see digest() below). The action result is the list of content
+  // digests of its outputs, in order. The outputs themselves are stored in
+  // the content-addressable storage (CAS) keyed by their digests. The
+  // storage layout is as follows:
+  //
+  // <root>/ac/<action-digest>  -- <output-digest> <size> line per output
+  // <root>/cas/<output-digest> -- output contents
+  //
+  // All the digests are SHA256. The cache is safe for concurrent use by
+  // multiple threads and build system processes (each entry is written into
+  // a temporary file that is then atomically renamed into place) and the
+  // root directory can reside on a shared (for example, network) filesystem
+  // which then acts as the server. Entries are never removed (the cache can
+  // be cleaned up by removing the directory while nothing is being built).
+  //
+  // Note that the outputs are copied rather than hardlinked since their
+  // modification times must be independent of those of the entries.
+  //
+  class LIBBUILD2_SYMEXPORT action_cache
+  {
+  public:
+    // The root directory is created if it does not exist.
+    //
+    explicit
+    action_cache (dir_path root);
+
+    // Return the content digest of the file. The result is memoized by the
+    // path and the modification time so that inputs shared by multiple
+    // actions (headers, libraries, etc) are only read once.
+    //
+    string
+    digest (const path&, timestamp mtime);
+
+    // Look up the action result and, if found, copy its outputs from the
+    // CAS into the specified paths returning true. Diagnose errors (an entry
+    // removed from under us, etc) as warnings and treat them as a miss.
+    //
+    bool
+    fetch (const string& action, const paths& outputs);
+
+    // Upload the outputs to the CAS and record the action result unless it
+    // already exists. Diagnose errors as warnings.
+    //
+    void
+    store (const string& action, const paths& outputs);
+
+    const dir_path&
+    root () const {return root_;}
+
+    // Return the action result entry path (for diagnostics).
+    //
+    path
+    entry (const string& action) const {return ac_ / path (action);}
+
+    action_cache (const action_cache&) = delete;
+    action_cache& operator= (const action_cache&) = delete;
+
+  private:
+    path
+    temp_path (const path&);
+
+  private:
+    dir_path root_;
+    dir_path ac_;
+    dir_path cas_;
+
+    struct digest_entry
+    {
+      timestamp mtime;
+      string    digest;
+    };
+
+    std::unordered_map<string, digest_entry> digests_;
+    shared_mutex digests_mutex_;
+  };
+}
+
+#endif // LIBBUILD2_ACTION_CACHE_HXX
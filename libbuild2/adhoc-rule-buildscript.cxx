@@ -16,6 +16,7 @@
 #include <libbuild2/filesystem.hxx>  // path_perms(), auto_rmfile
 #include <libbuild2/diagnostics.hxx>
 #include <libbuild2/make-parser.hxx>
+#include <libbuild2/action-cache.hxx>
 
 #include <libbuild2/parser.hxx> // attributes
 
@@ -1860,6 +1861,74 @@ namespace build2
       return *ps;
     }
 
+    // Try to get the target from the action cache.
+    //
+    // We only do this for a single file target whose dependency changes are
+    // fully tracked by depdb (which then captures the script, variables,
+    // target and prerequisite sets, programs, and environment). The action
+    // key is the depdb contents plus the content digests of all the file
+    // prerequisites.
+    //
+    string ack;
+    if (ctx.acache != nullptr     &&
+        g == nullptr              &&
+        t.adhoc_member == nullptr &&
+        !depdb_preamble           &&
+        !script.depdb_clear       &&
+        !ctx.dry_run)
+    {
+      action_cache& ac (*ctx.acache);
+
+      sha256 cs;
+      {
+        mapped_file mf (dd.path);
+        cs.append (mf.data (), mf.size ());
+      }
+
+      for (const prerequisite_target& p: t.prerequisite_targets[a])
+      {
+        if (const target* pt =
+            (p.target != nullptr ? p.target :
+             p.adhoc ()          ? reinterpret_cast<target*> (p.data)
+             : nullptr))
+        {
+          if ((p.include & include_unmatch) != 0) // Skip update=unmatch.
+            continue;
+
+          if (const file* f = pt->is_a<file> ())
+          {
+            const path& fp (f->path ());
+
+            if (!fp.empty ())
+            {
+              timestamp fm (f->load_mtime ());
+
+              if (fm != timestamp_nonexistent)
+              {
+                cs.append (fp.string ());
+                cs.append (ac.digest (fp, fm));
+              }
+            }
+          }
+        }
+      }
+
+      ack = cs.string ();
+
+      if (ac.fetch (ack, paths {tp}))
+      {
+        if (verb >= 2)
+          text << "cp " << ac.entry (ack) << ' ' << tp;
+        else if (verb)
+          print_diag ("cp", ac.entry (ack), t);
+
+        dd.check_mtime (tp);
+
+        ft.mtime (system_clock::now ());
+        return target_state::changed;
+      }
+    }
+
     bool r (false);
     if (!ctx.dry_run || verb != 0)
     {
@@ -1872,7 +1941,12 @@ namespace build2
       if (r)
       {
         if (!ctx.dry_run)
+        {
           dd.check_mtime (tp);
+
+          if (!ack.empty ())
+            ctx.acache->store (ack, paths {tp});
+        }
       }
     }
 
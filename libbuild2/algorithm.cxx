@@ -12,6 +12,8 @@
 #include <libbuild2/filesystem.hxx>
 #include <libbuild2/diagnostics.hxx>
 #include <libbuild2/prerequisite.hxx>
+#include <libbuild2/timeline.hxx>
+#include <libbuild2/target-durations.hxx>
 
 using namespace std;
 using namespace butl;
@@ -547,26 +549,147 @@ namespace build2
     return r.first;
   }
 
-  // Return the matching rule or NULL if no match and try_match is true.
+  // Return the list of rule match candidates for the specified base scope,
+  // target type, action, and rule hint (see match_rule_cache for details).
   //
-  const rule_match*
-  match_rule (action a, target& t,
-              const rule* skip,
-              bool try_match,
-              match_extra* pme)
+  static shared_ptr<const match_rule_candidates>
+  match_candidates (context& ctx,
+                    const scope& bs,
+                    const target_type& ttype,
+                    meta_operation_id mo,
+                    operation_id o,
+                    const string& hint,
+                    bool retry)
   {
     using fallback_rule = adhoc_rule_pattern::fallback_rule;
 
-    auto adhoc_rule_match = [] (const rule_match& r)
+    // Only cache during the match phase (rules are registered during load).
+    //
+    bool cache (ctx.phase == run_phase::match);
+
+    match_rule_cache::key k {&bs, &ttype, mo, o, hint, retry};
+
+    if (cache)
     {
-      return dynamic_cast<const adhoc_rule*> (&r.second.get ());
-    };
+      if (auto r = ctx.match_cache.find (k, ctx.load_generation))
+        return r;
+    }
+
+    shared_ptr<match_rule_candidates> p (make_shared<match_rule_candidates> ());
+    p->generation = ctx.load_generation;
+    vector<match_rule_candidate>& cs (p->candidates);
 
-    auto fallback_rule_match = [] (const rule_match& r)
+    for (auto tt (&ttype); tt != nullptr; tt = tt->base)
     {
-      return dynamic_cast<const fallback_rule*> (&r.second.get ());
-    };
+      // Search scopes outwards, stopping at the project root. For retry only
+      // look in the root and global scopes.
+      //
+      for (const scope* s (retry ? bs.root_scope () : &bs);
+           s != nullptr;
+           s = s->root () ? &s->global_scope () : s->parent_scope ())
+      {
+        const operation_rule_map* om (s->rules[mo]);
+
+        if (om == nullptr)
+          continue; // No entry for this meta-operation id.
+
+        // First try the map for the actual operation. If that doesn't yeld
+        // anything, try the wildcard map.
+        //
+        for (operation_id oi (o), oip (o); oip != 0; oip = oi, oi = 0)
+        {
+          const target_type_rule_map* ttm ((*om)[oi]);
+
+          if (ttm == nullptr)
+            continue; // No entry for this operation id.
+
+          if (ttm->empty ())
+            continue; // Empty map for this operation id.
+
+          auto i (ttm->find (tt));
+
+          if (i == ttm->end () || i->second.empty ())
+            continue; // No rules registered for this target type.
+
+          const auto& rules (i->second); // Name map.
+
+          // Filter against the hint, if any.
+          //
+          auto rs (hint.empty ()
+                   ? make_pair (rules.begin (), rules.end ())
+                   : rules.find_sub (hint));
+
+          size_t b (cs.size ());
+
+          for (auto i (rs.first); i != rs.second; ++i)
+          {
+            const rule_match* r (&*i);
+
+            // In a somewhat hackish way we reuse operation wildcards to
+            // plumb the ad hoc rule's reverse operation fallback logic.
+            //
+            // The difficulty is two-fold:
+            //
+            // 1. It's difficult to add the fallback flag to the rule map
+            //    because of rule_match which is used throughout.
+            //
+            // 2. Even if we could do that, we pass the reverse action to
+            //    reverse_fallback() rather than it returning (a list) of
+            //    reverse actions, which would be necessary to register them.
+            //
+            if (oi == 0)
+            {
+              if (const fallback_rule* fr =
+                  dynamic_cast<const fallback_rule*> (&r->second.get ()))
+              {
+                r = nullptr;
+                for (const shared_ptr<adhoc_rule>& ar: fr->rules)
+                {
+                  if (ar->reverse_fallback (action (mo, o), *tt))
+                  {
+                    r = &ar->rule_match;
+                    break;
+                  }
+                }
 
+                if (r == nullptr)
+                  continue;
+              }
+            }
+
+            const rule& ru (r->second);
+
+            cs.push_back (
+              match_rule_candidate {
+                r,
+                0,
+                oi == 0 /* fallback */,
+                dynamic_cast<const adhoc_rule*> (&ru) != nullptr,
+                ru.match_independent ()});
+          }
+
+          for (size_t e (cs.size ()); b != e; ++b)
+            cs[b].group_end = e;
+        }
+      }
+    }
+
+    p->decision.store (cs.size (), memory_order_relaxed);
+
+    if (cache)
+      ctx.match_cache.insert (move (k), p);
+
+    return p;
+  }
+
+  // Return the matching rule or NULL if no match and try_match is true.
+  //
+  const rule_match*
+  match_rule (action a, target& t,
+              const rule* skip,
+              bool try_match,
+              match_extra* pme)
+  {
     if (const target* g = t.group)
     {
       // If this is a group with dynamic members, then match it with the
@@ -669,168 +792,119 @@ namespace build2
         ? &empty_string
         : &t.find_hint (o); // MT-safe (target locked).
 
-      for (auto tt (&t.type ()); tt != nullptr; tt = tt->base)
-      {
-        // Search scopes outwards, stopping at the project root. For retry
-        // only look in the root and global scopes.
-        //
-        for (const scope* s (retry ? bs.root_scope () : &bs);
-             s != nullptr;
-             s = s->root () ? &s->global_scope () : s->parent_scope ())
-        {
-          const operation_rule_map* om (s->rules[mo]);
+      shared_ptr<const match_rule_candidates> rcs (
+        match_candidates (t.ctx, bs, t.type (), mo, o, *hint, retry));
 
-          if (om == nullptr)
-            continue; // No entry for this meta-operation id.
+      const vector<match_rule_candidate>& cs (rcs->candidates);
+      size_t cn (cs.size ());
 
-          // First try the map for the actual operation. If that doesn't yeld
-          // anything, try the wildcard map.
-          //
-          for (operation_id oi (o), oip (o); oip != 0; oip = oi, oi = 0)
-          {
-            const target_type_rule_map* ttm ((*om)[oi]);
-
-            if (ttm == nullptr)
-              continue; // No entry for this operation id.
-
-            if (ttm->empty ())
-              continue; // Empty map for this operation id.
+      // If the decision has been cached, then we can skip calling match()
+      // (see match_rule_cache for details). Note that it is only cached and
+      // used for the common case of a locked target without a rule to skip.
+      //
+      bool cacheable (me.locked && skip == nullptr);
 
-            auto i (ttm->find (tt));
+      if (cacheable)
+      {
+        size_t d (rcs->decision.load (memory_order_acquire));
 
-            if (i == ttm->end () || i->second.empty ())
-              continue; // No rules registered for this target type.
+        if (d != cn)
+        {
+          const match_rule_candidate& c (cs[d]);
+          me.init (c.fallback);
+          return c.rule;
+        }
+      }
 
-            const auto& rules (i->second); // Name map.
+      for (size_t i (0); i != cn; ++i)
+      {
+        const match_rule_candidate& c (cs[i]);
 
-            // Filter against the hint, if any.
-            //
-            auto rs (hint->empty ()
-                     ? make_pair (rules.begin (), rules.end ())
-                     : rules.find_sub (*hint));
+        // Skip non-ad hoc rules if the target is not locked (see above).
+        //
+        if (!me.locked && !c.adhoc)
+          continue;
 
-            for (auto i (rs.first); i != rs.second; ++i)
-            {
-              const rule_match* r (&*i);
+        const rule_match* r (c.rule);
+        const string& n (r->first);
+        const rule& ru (r->second);
 
-              // In a somewhat hackish way we reuse operation wildcards to
-              // plumb the ad hoc rule's reverse operation fallback logic.
-              //
-              // The difficulty is two-fold:
-              //
-              // 1. It's difficult to add the fallback flag to the rule map
-              //    because of rule_match which is used throughout.
-              //
-              // 2. Even if we could do that, we pass the reverse action to
-              //    reverse_fallback() rather than it returning (a list) of
-              //    reverse actions, which would be necessary to register them.
-              //
-              auto find_fallback = [mo, o, tt] (const fallback_rule& fr)
-                -> const rule_match*
-              {
-                for (const shared_ptr<adhoc_rule>& ar: fr.rules)
-                  if (ar->reverse_fallback (action (mo, o), *tt))
-                    return &ar->rule_match;
+        if (&ru == skip)
+          continue;
 
-                return nullptr;
-              };
+        cacheable = cacheable && c.independent;
 
-              if (oi == 0)
-              {
-                if (const fallback_rule* fr = fallback_rule_match (*r))
-                {
-                  if ((r = find_fallback (*fr)) == nullptr)
-                    continue;
-                }
-              }
+        me.init (c.fallback);
+        {
+          auto df = make_diag_frame (
+            [a, &t, &n](const diag_record& dr)
+            {
+              if (verb != 0)
+                dr << info << "while matching rule " << n << " to "
+                   << diag_do (a, t);
+            });
 
-              // Skip non-ad hoc rules if the target is not locked (see
-              // above).
-              //
-              if (!me.locked && !adhoc_rule_match (*r))
-                continue;
+          if (!ru.match (a, t, *hint, me))
+            continue;
+        }
 
-              const string& n (r->first);
-              const rule& ru (r->second);
+        // Do the ambiguity test.
+        //
+        bool ambig (false);
 
-              if (&ru == skip)
-                continue;
+        diag_record dr;
+        for (size_t j (i + 1); j != c.group_end; ++j)
+        {
+          const match_rule_candidate& c1 (cs[j]);
 
-              me.init (oi == 0 /* fallback */);
-              {
-                auto df = make_diag_frame (
-                  [a, &t, &n](const diag_record& dr)
-                  {
-                    if (verb != 0)
-                      dr << info << "while matching rule " << n << " to "
-                         << diag_do (a, t);
-                  });
+          if (!me.locked && !c1.adhoc)
+            continue;
 
-                if (!ru.match (a, t, *hint, me))
-                  continue;
-              }
+          const rule_match* r1 (c1.rule);
+          const string& n1 (r1->first);
+          const rule& ru1 (r1->second);
 
-              // Do the ambiguity test.
-              //
-              bool ambig (false);
+          cacheable = cacheable && c1.independent;
 
-              diag_record dr;
-              for (++i; i != rs.second; ++i)
+          {
+            auto df = make_diag_frame (
+              [a, &t, &n1](const diag_record& dr)
               {
-                const rule_match* r1 (&*i);
-
-                if (oi == 0)
-                {
-                  if (const fallback_rule* fr = fallback_rule_match (*r1))
-                  {
-                    if ((r1 = find_fallback (*fr)) == nullptr)
-                      continue;
-                  }
-                }
-
-                if (!me.locked && !adhoc_rule_match (*r1))
-                  continue;
-
-                const string& n1 (r1->first);
-                const rule& ru1 (r1->second);
+                if (verb != 0)
+                  dr << info << "while matching rule " << n1 << " to "
+                     << diag_do (a, t);
+              });
+
+            // @@ TODO: this makes target state in match() undetermined
+            //    so need to fortify rules that modify anything in match
+            //    to clear things.
+            //
+            // @@ Can't we temporarily swap things out in target?
+            //
+            match_extra me1 (me.locked, c1.fallback);
+            if (!ru1.match (a, t, *hint, me1))
+              continue;
+          }
 
-                {
-                  auto df = make_diag_frame (
-                    [a, &t, &n1](const diag_record& dr)
-                    {
-                      if (verb != 0)
-                        dr << info << "while matching rule " << n1 << " to "
-                           << diag_do (a, t);
-                    });
-
-                  // @@ TODO: this makes target state in match() undetermined
-                  //    so need to fortify rules that modify anything in match
-                  //    to clear things.
-                  //
-                  // @@ Can't we temporarily swap things out in target?
-                  //
-                  match_extra me1 (me.locked, oi == 0 /* fallback */);
-                  if (!ru1.match (a, t, *hint, me1))
-                    continue;
-                }
+          if (!ambig)
+          {
+            dr << fail << "multiple rules matching " << diag_doing (a, t)
+               << info << "rule " << n << " matches";
+            ambig = true;
+          }
 
-                if (!ambig)
-                {
-                  dr << fail << "multiple rules matching " << diag_doing (a, t)
-                     << info << "rule " << n << " matches";
-                  ambig = true;
-                }
+          dr << info << "rule " << n1 << " also matches";
+        }
 
-                dr << info << "rule " << n1 << " also matches";
-              }
+        if (!ambig)
+        {
+          if (cacheable)
+            rcs->decision.store (i, memory_order_release);
 
-              if (!ambig)
-                return r;
-              else
-                dr << info << "use rule hint to disambiguate this match";
-            }
-          }
+          return r;
         }
+        else
+          dr << info << "use rule hint to disambiguate this match";
       }
 
       if (mo == perform_id || hint->empty () || retry)
@@ -1103,7 +1177,11 @@ namespace build2
           //
           clear_target (a, t);
 
-          const rule_match* r (match_rule (a, t, nullptr, try_match));
+          const rule_match* r;
+          {
+            timeline_scope tls (timeline::category::match, a, t);
+            r = match_rule (a, t, nullptr, try_match);
+          }
 
           assert (l.offset != target::offset_tried); // Should have failed.
 
@@ -1127,7 +1205,10 @@ namespace build2
         {
           // Apply.
           //
-          set_recipe (l, apply_impl (a, t, *s.rule));
+          {
+            timeline_scope tls (timeline::category::apply, a, t);
+            set_recipe (l, apply_impl (a, t, *s.rule));
+          }
           l.offset = target::offset_applied;
           break;
         }
@@ -2482,7 +2563,16 @@ namespace build2
           dr << info << "using directly-assigned recipe";
       }
 
-      ts = execute_recipe (a, t, s.recipe);
+      timeline_scope tls (timeline::category::execute, a, t);
+
+      if (ctx.durations != nullptr)
+      {
+        timestamp st (system_clock::now ());
+        ts = execute_recipe (a, t, s.recipe);
+        ctx.durations->record (a, t, ts, st, system_clock::now ());
+      }
+      else
+        ts = execute_recipe (a, t, s.recipe);
 
       if (blm)
       {
@@ -2922,6 +3012,59 @@ namespace build2
       pt.target = nullptr;
   }
 
+  // If we have the predicted critical paths (see target_durations for
+  // details), then return the order in which to start the execution of the
+  // specified targets: the longest predicted critical path first. Otherwise,
+  // return empty order, which means the declaration order.
+  //
+  // Note that helper threads take tasks from the front of the queue while
+  // the waiting thread works its own queue from the back. So with this
+  // order the long poles are started first by helpers while the short ones
+  // are executed by us.
+  //
+  using execute_order_type = small_vector<size_t, 16>;
+
+  template <typename T>
+  static execute_order_type
+  execute_order (context& ctx, action a, T ts[], size_t n)
+  {
+    execute_order_type r;
+
+    if (ctx.durations == nullptr || !ctx.durations->predicting () || n < 2)
+      return r;
+
+    small_vector<pair<duration, size_t>, 16> ps;
+    ps.reserve (n);
+
+    bool any (false);
+    for (size_t i (0); i != n; ++i)
+    {
+      const target* t (ts[i]);
+      duration d (t != nullptr ? (*t)[a].exec_predicted : duration::min ());
+
+      if (d > duration::zero ())
+        any = true;
+
+      ps.emplace_back (d, i);
+    }
+
+    if (any)
+    {
+      stable_sort (ps.begin (), ps.end (),
+                   [] (const pair<duration, size_t>& x,
+                       const pair<duration, size_t>& y)
+                   {
+                     return x.first > y.first;
+                   });
+
+      r.reserve (n);
+      for (const pair<duration, size_t>& p: ps)
+        r.push_back (p.second);
+    }
+
+    return r;
+  }
+
   template <typename T>
   target_state
   straight_execute_members (context& ctx, action a, atomic_count& tc,
@@ -2935,10 +3078,11 @@ namespace build2
     //
     wait_guard wg (ctx, busy, tc);
 
-    n += p;
-    for (size_t i (p); i != n; ++i)
+    execute_order_type ord (execute_order (ctx, a, ts + p, n));
+
+    for (size_t j (0); j != n; ++j)
     {
-      const target*& mt (ts[i]);
+      const target*& mt (ts[p + (ord.empty () ? j : ord[j])]);
 
       if (mt == nullptr) // Skipped.
         continue;
@@ -2958,6 +3102,7 @@ namespace build2
     // or executed and synchronized (and we have blanked out all the postponed
     // ones).
     //
+    n += p;
     for (size_t i (p); i != n; ++i)
     {
       if (ts[i] == nullptr)
@@ -3059,9 +3204,11 @@ namespace build2
 
     wait_guard wg (ctx, busy, t[a].task_count);
 
-    for (size_t i (0); i != n; ++i)
+    execute_order_type ord (execute_order (ctx, a, pts.data (), n));
+
+    for (size_t j (0); j != n; ++j)
     {
-      const target*& pt (pts[i]);
+      const target*& pt (pts[ord.empty () ? j : ord[j]]);
 
       if (pt == nullptr) // Skipped.
         continue;
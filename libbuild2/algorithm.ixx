@@ -539,6 +539,9 @@ namespace build2
     s.recipe = nullptr;
     s.recipe_keep = false;
     s.resolve_counted = false;
+    s.exec_end.store (0, memory_order_relaxed);
+    s.exec_path.store (0, memory_order_relaxed);
+    s.exec_predicted = duration::min ();
     s.vars.clear ();
     t.prerequisite_targets[a].clear ();
   }
@@ -336,6 +336,10 @@ namespace build2
     verbose_ (1),
     verbose_specified_ (false),
     stat_ (),
+    critical_path_ (),
+    critical_path_specified_ (false),
+    trace_ (),
+    trace_specified_ (false),
     progress_ (),
     no_progress_ (),
     diag_color_ (),
@@ -350,11 +354,23 @@ namespace build2
     file_cache_specified_ (false),
     max_stack_ (),
     max_stack_specified_ (false),
+    jobserver_ (),
+    jobserver_specified_ (false),
+    worker_pool_ (),
+    worker_pool_specified_ (false),
+    worker_serve_ (),
+    worker_serve_specified_ (false),
+    action_cache_ (),
+    action_cache_specified_ (false),
     serial_stop_ (),
     dry_run_ (),
     no_diag_buffer_ (),
+    diag_reactor_ (),
     match_only_ (),
     load_only_ (),
+    target_arena_ (),
+    fast_exit_ (),
+    futex_wait_ (),
     no_external_modules_ (),
     structured_result_ (),
     structured_result_specified_ (false),
@@ -506,6 +522,20 @@ namespace build2
         this->stat_, a.stat_);
     }
 
+    if (a.critical_path_specified_)
+    {
+      ::build2::build::cli::parser< path>::merge (
+        this->critical_path_, a.critical_path_);
+      this->critical_path_specified_ = true;
+    }
+
+    if (a.trace_specified_)
+    {
+      ::build2::build::cli::parser< path>::merge (
+        this->trace_, a.trace_);
+      this->trace_specified_ = true;
+    }
+
     if (a.progress_)
     {
       ::build2::build::cli::parser< bool>::merge (
@@ -565,6 +595,34 @@ namespace build2
       this->max_stack_specified_ = true;
     }
 
+    if (a.jobserver_specified_)
+    {
+      ::build2::build::cli::parser< string>::merge (
+        this->jobserver_, a.jobserver_);
+      this->jobserver_specified_ = true;
+    }
+
+    if (a.worker_pool_specified_)
+    {
+      ::build2::build::cli::parser< path>::merge (
+        this->worker_pool_, a.worker_pool_);
+      this->worker_pool_specified_ = true;
+    }
+
+    if (a.worker_serve_specified_)
+    {
+      ::build2::build::cli::parser< path>::merge (
+        this->worker_serve_, a.worker_serve_);
+      this->worker_serve_specified_ = true;
+    }
+
+    if (a.action_cache_specified_)
+    {
+      ::build2::build::cli::parser< dir_path>::merge (
+        this->action_cache_, a.action_cache_);
+      this->action_cache_specified_ = true;
+    }
+
     if (a.serial_stop_)
     {
       ::build2::build::cli::parser< bool>::merge (
@@ -583,6 +641,12 @@ namespace build2
         this->no_diag_buffer_, a.no_diag_buffer_);
     }
 
+    if (a.diag_reactor_)
+    {
+      ::build2::build::cli::parser< bool>::merge (
+        this->diag_reactor_, a.diag_reactor_);
+    }
+
     if (a.match_only_)
     {
       ::build2::build::cli::parser< bool>::merge (
@@ -595,6 +659,24 @@ namespace build2
         this->load_only_, a.load_only_);
     }
 
+    if (a.target_arena_)
+    {
+      ::build2::build::cli::parser< bool>::merge (
+        this->target_arena_, a.target_arena_);
+    }
+
+    if (a.fast_exit_)
+    {
+      ::build2::build::cli::parser< bool>::merge (
+        this->fast_exit_, a.fast_exit_);
+    }
+
+    if (a.futex_wait_)
+    {
+      ::build2::build::cli::parser< bool>::merge (
+        this->futex_wait_, a.futex_wait_);
+    }
+
     if (a.no_external_modules_)
     {
       ::build2::build::cli::parser< bool>::merge (
@@ -789,6 +871,24 @@ namespace build2
     os << std::endl
        << "\033[1m--stat\033[0m                  Display build statistics." << ::std::endl;
 
+    os << std::endl
+       << "\033[1m--critical-path\033[0m \033[4mfile\033[0m    Record target execution durations in \033[4mfile\033[0m and use the" << ::std::endl
+       << "                        durations recorded by previous runs to predict the" << ::std::endl
+       << "                        critical path of each target. The prerequisites with the" << ::std::endl
+       << "                        longest predicted critical path are then started first" << ::std::endl
+       << "                        so that long poles are not started last. Only the" << ::std::endl
+       << "                        durations of targets that were actually changed are" << ::std::endl
+       << "                        recorded. See also \033[1m--stat\033[0m which prints the predicted" << ::std::endl
+       << "                        and actual critical paths." << ::std::endl;
+
+    os << std::endl
+       << "\033[1m--trace\033[0m \033[4mfile\033[0m            Write the build timeline to \033[4mfile\033[0m in the Chrome trace" << ::std::endl
+       << "                        event format that can be viewed with" << ::std::endl
+       << "                        \033[1mchrome://tracing\033[0m or Perfetto. The timeline includes" << ::std::endl
+       << "                        the match, apply, and execute steps of each target," << ::std::endl
+       << "                        external processes, phase switches, and scheduler" << ::std::endl
+       << "                        waits." << ::std::endl;
+
     os << std::endl
        << "\033[1m--progress\033[0m              Display build progress. If printing to a terminal the" << ::std::endl
        << "                        progress is displayed by default for low verbosity" << ::std::endl
@@ -856,6 +956,49 @@ namespace build2
        << "                        with the special zero value indicating that the main" << ::std::endl
        << "                        thread stack size should be used as is." << ::std::endl;
 
+    os << std::endl
+       << "\033[1m--jobserver\033[0m \033[4mmode\033[0m        GNU make jobserver mode. Valid values are \033[1mclient\033[0m" << ::std::endl
+       << "                        (acquire a token from the jobserver specified in the" << ::std::endl
+       << "                        \033[1mMAKEFLAGS\033[0m environment variable before running each" << ::std::endl
+       << "                        additional job, if there is one), \033[1mserver\033[0m (as \033[1mclient\033[0m but" << ::std::endl
+       << "                        if there is no jobserver, then create one with the" << ::std::endl
+       << "                        number of jobs specified with \033[1m--jobs|-j\033[0m and pass it to" << ::std::endl
+       << "                        the child processes in \033[1mMAKEFLAGS\033[0m), and \033[1mnone\033[0m (ignore any" << ::std::endl
+       << "                        jobserver). If this option is not specified, then" << ::std::endl
+       << "                        \033[1mclient\033[0m is assumed unless \033[1m--jobs|-j\033[0m is specified, in" << ::std::endl
+       << "                        which case \033[1mnone\033[0m is assumed. Note that this means that" << ::std::endl
+       << "                        by default, when executed from a \033[1mmake\033[0m recipe, the build" << ::std::endl
+       << "                        system shares the job limit with \033[1mmake\033[0m. If a jobserver" << ::std::endl
+       << "                        is in use, then GCC link-time optimization is also" << ::std::endl
+       << "                        performed using the jobserver (\033[1m-flto=jobserver\033[0m). The" << ::std::endl
+       << "                        jobserver is currently only supported on POSIX." << ::std::endl;
+
+    os << std::endl
+       << "\033[1m--worker-pool\033[0m \033[4msocket\033[0m    Execute the compilation command lines through the local" << ::std::endl
+       << "                        worker pool daemon listening on the Unix-domain" << ::std::endl
+       << "                        \033[4msocket\033[0m (see \033[1m--worker-serve\033[0m). The worker thread that" << ::std::endl
+       << "                        submits a job does not occupy an active thread slot" << ::std::endl
+       << "                        while waiting for the result. The worker pool is" << ::std::endl
+       << "                        currently only supported on POSIX." << ::std::endl;
+
+    os << std::endl
+       << "\033[1m--worker-serve\033[0m \033[4msocket\033[0m   Run as the local worker pool daemon listening on the" << ::std::endl
+       << "                        Unix-domain \033[4msocket\033[0m and executing command lines" << ::std::endl
+       << "                        submitted by the build system processes started with" << ::std::endl
+       << "                        \033[1m--worker-pool\033[0m, up to the number of jobs specified with" << ::std::endl
+       << "                        \033[1m--jobs|-j\033[0m at a time. In this mode no buildspec is" << ::std::endl
+       << "                        expected and the daemon runs until terminated." << ::std::endl;
+
+    os << std::endl
+       << "\033[1m--action-cache\033[0m \033[4mdir\033[0m      Look up the results of the compile, link, and ad hoc" << ::std::endl
+       << "                        buildscript recipes in the content-addressed action" << ::std::endl
+       << "                        cache in \033[4mdir\033[0m and store them there on a miss. An" << ::std::endl
+       << "                        action is identified by the digest of its command line" << ::std::endl
+       << "                        or script, environment, and the paths and contents of" << ::std::endl
+       << "                        its inputs. The directory can reside on a shared" << ::std::endl
+       << "                        filesystem in order to share the results between" << ::std::endl
+       << "                        machines." << ::std::endl;
+
     os << std::endl
        << "\033[1m--serial-stop\033[0m|\033[1m-s\033[0m        Run serially and stop at the first error. This mode is" << ::std::endl
        << "                        useful to investigate build failures that are caused by" << ::std::endl
@@ -889,6 +1032,14 @@ namespace build2
        << "                        invoked, the interleaving diagnostics may not break" << ::std::endl
        << "                        lines and thus could be tolerable." << ::std::endl;
 
+    os << std::endl
+       << "\033[1m--diag-reactor\033[0m          Read buffered diagnostics from child processes using a" << ::std::endl
+       << "                        single I/O thread instead of blocking the worker thread" << ::std::endl
+       << "                        until each child exits. This allows the scheduler to" << ::std::endl
+       << "                        deactivate the waiting worker thread and start other" << ::std::endl
+       << "                        work, including other child processes, in the meantime." << ::std::endl
+       << "                        Currently only supported on Linux." << ::std::endl;
+
     os << std::endl
        << "\033[1m--match-only\033[0m            Match the rules without executing the operation. This" << ::std::endl
        << "                        mode is primarily useful for profiling and dumping the" << ::std::endl
@@ -903,6 +1054,32 @@ namespace build2
        << "                        the \033[1mperform(update)\033[0m action on an \033[1malias{}\033[0m target," << ::std::endl
        << "                        usually \033[1mdir{}\033[0m." << ::std::endl;
 
+    os << std::endl
+       << "\033[1m--target-arena\033[0m          Allocate targets from a per-context memory arena that" << ::std::endl
+       << "                        is released all at once when the context is destroyed." << ::std::endl
+       << "                        This reduces the memory allocation overhead and" << ::std::endl
+       << "                        fragmentation for builds with a large number of targets" << ::std::endl
+       << "                        at the expense of not reusing the memory of targets" << ::std::endl
+       << "                        that are discarded during the build. The amount of" << ::std::endl
+       << "                        memory allocated from the arena is printed with" << ::std::endl
+       << "                        \033[1m--stat\033[0m." << ::std::endl;
+
+    os << std::endl
+       << "\033[1m--fast-exit\033[0m             Skip destroying the build state at the end of a" << ::std::endl
+       << "                        successful build and let the process exit release its" << ::std::endl
+       << "                        memory. For large builds destroying the build state" << ::std::endl
+       << "                        (targets, scopes, variables, etc) can take a noticeable" << ::std::endl
+       << "                        amount of time. Note that in this mode temporary files" << ::std::endl
+       << "                        that are still referenced from the build state at the" << ::std::endl
+       << "                        end of the build, if any, are not removed." << ::std::endl;
+
+    os << std::endl
+       << "\033[1m--futex-wait\033[0m            Use futex-based waiting in the scheduler. In this mode" << ::std::endl
+       << "                        threads waiting for tasks to complete sleep directly on" << ::std::endl
+       << "                        a futex word which is woken up without taking any" << ::std::endl
+       << "                        locks. Currently only supported on Linux and ignored on" << ::std::endl
+       << "                        other platforms." << ::std::endl;
+
     os << std::endl
        << "\033[1m--no-external-modules\033[0m   Don't load external modules during project bootstrap." << ::std::endl
        << "                        Note that this option can only be used with" << ::std::endl
@@ -1168,6 +1345,12 @@ namespace build2
         &b_options::verbose_specified_ >;
       _cli_b_options_map_["--stat"] =
       &::build2::build::cli::thunk< b_options, &b_options::stat_ >;
+      _cli_b_options_map_["--critical-path"] =
+      &::build2::build::cli::thunk< b_options, path, &b_options::critical_path_,
+        &b_options::critical_path_specified_ >;
+      _cli_b_options_map_["--trace"] =
+      &::build2::build::cli::thunk< b_options, path, &b_options::trace_,
+        &b_options::trace_specified_ >;
       _cli_b_options_map_["--progress"] =
       &::build2::build::cli::thunk< b_options, &b_options::progress_ >;
       _cli_b_options_map_["--no-progress"] =
@@ -1200,6 +1383,18 @@ namespace build2
       _cli_b_options_map_["--max-stack"] =
       &::build2::build::cli::thunk< b_options, size_t, &b_options::max_stack_,
         &b_options::max_stack_specified_ >;
+      _cli_b_options_map_["--jobserver"] =
+      &::build2::build::cli::thunk< b_options, string, &b_options::jobserver_,
+        &b_options::jobserver_specified_ >;
+      _cli_b_options_map_["--worker-pool"] =
+      &::build2::build::cli::thunk< b_options, path, &b_options::worker_pool_,
+        &b_options::worker_pool_specified_ >;
+      _cli_b_options_map_["--worker-serve"] =
+      &::build2::build::cli::thunk< b_options, path, &b_options::worker_serve_,
+        &b_options::worker_serve_specified_ >;
+      _cli_b_options_map_["--action-cache"] =
+      &::build2::build::cli::thunk< b_options, dir_path, &b_options::action_cache_,
+        &b_options::action_cache_specified_ >;
       _cli_b_options_map_["--serial-stop"] =
       &::build2::build::cli::thunk< b_options, &b_options::serial_stop_ >;
       _cli_b_options_map_["-s"] =
@@ -1210,10 +1405,18 @@ namespace build2
       &::build2::build::cli::thunk< b_options, &b_options::dry_run_ >;
       _cli_b_options_map_["--no-diag-buffer"] =
       &::build2::build::cli::thunk< b_options, &b_options::no_diag_buffer_ >;
+      _cli_b_options_map_["--diag-reactor"] =
+      &::build2::build::cli::thunk< b_options, &b_options::diag_reactor_ >;
       _cli_b_options_map_["--match-only"] =
       &::build2::build::cli::thunk< b_options, &b_options::match_only_ >;
       _cli_b_options_map_["--load-only"] =
       &::build2::build::cli::thunk< b_options, &b_options::load_only_ >;
+      _cli_b_options_map_["--target-arena"] =
+      &::build2::build::cli::thunk< b_options, &b_options::target_arena_ >;
+      _cli_b_options_map_["--fast-exit"] =
+      &::build2::build::cli::thunk< b_options, &b_options::fast_exit_ >;
+      _cli_b_options_map_["--futex-wait"] =
+      &::build2::build::cli::thunk< b_options, &b_options::futex_wait_ >;
       _cli_b_options_map_["--no-external-modules"] =
       &::build2::build::cli::thunk< b_options, &b_options::no_external_modules_ >;
       _cli_b_options_map_["--structured-result"] =
@@ -96,6 +96,18 @@ namespace build2
     const bool&
     stat () const;
 
+    const path&
+    critical_path () const;
+
+    bool
+    critical_path_specified () const;
+
+    const path&
+    trace () const;
+
+    bool
+    trace_specified () const;
+
     const bool&
     progress () const;
 
@@ -138,6 +150,30 @@ namespace build2
     bool
     max_stack_specified () const;
 
+    const string&
+    jobserver () const;
+
+    bool
+    jobserver_specified () const;
+
+    const path&
+    worker_pool () const;
+
+    bool
+    worker_pool_specified () const;
+
+    const path&
+    worker_serve () const;
+
+    bool
+    worker_serve_specified () const;
+
+    const dir_path&
+    action_cache () const;
+
+    bool
+    action_cache_specified () const;
+
     const bool&
     serial_stop () const;
 
@@ -147,12 +183,24 @@ namespace build2
     const bool&
     no_diag_buffer () const;
 
+    const bool&
+    diag_reactor () const;
+
     const bool&
     match_only () const;
 
     const bool&
     load_only () const;
 
+    const bool&
+    target_arena () const;
+
+    const bool&
+    fast_exit () const;
+
+    const bool&
+    futex_wait () const;
+
     const bool&
     no_external_modules () const;
 
@@ -289,6 +337,10 @@ namespace build2
     uint16_t verbose_;
     bool verbose_specified_;
     bool stat_;
+    path critical_path_;
+    bool critical_path_specified_;
+    path trace_;
+    bool trace_specified_;
     bool progress_;
     bool no_progress_;
     bool diag_color_;
@@ -303,11 +355,23 @@ namespace build2
     bool file_cache_specified_;
     size_t max_stack_;
     bool max_stack_specified_;
+    string jobserver_;
+    bool jobserver_specified_;
+    path worker_pool_;
+    bool worker_pool_specified_;
+    path worker_serve_;
+    bool worker_serve_specified_;
+    dir_path action_cache_;
+    bool action_cache_specified_;
     bool serial_stop_;
     bool dry_run_;
     bool no_diag_buffer_;
+    bool diag_reactor_;
     bool match_only_;
     bool load_only_;
+    bool target_arena_;
+    bool fast_exit_;
+    bool futex_wait_;
     bool no_external_modules_;
     structured_result_format structured_result_;
     bool structured_result_specified_;
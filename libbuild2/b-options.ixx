@@ -68,6 +68,30 @@ namespace build2
     return this->stat_;
   }
 
+  inline const path& b_options::
+  critical_path () const
+  {
+    return this->critical_path_;
+  }
+
+  inline bool b_options::
+  critical_path_specified () const
+  {
+    return this->critical_path_specified_;
+  }
+
+  inline const path& b_options::
+  trace () const
+  {
+    return this->trace_;
+  }
+
+  inline bool b_options::
+  trace_specified () const
+  {
+    return this->trace_specified_;
+  }
+
   inline const bool& b_options::
   progress () const
   {
@@ -152,6 +176,54 @@ namespace build2
     return this->max_stack_specified_;
   }
 
+  inline const string& b_options::
+  jobserver () const
+  {
+    return this->jobserver_;
+  }
+
+  inline bool b_options::
+  jobserver_specified () const
+  {
+    return this->jobserver_specified_;
+  }
+
+  inline const path& b_options::
+  worker_pool () const
+  {
+    return this->worker_pool_;
+  }
+
+  inline bool b_options::
+  worker_pool_specified () const
+  {
+    return this->worker_pool_specified_;
+  }
+
+  inline const path& b_options::
+  worker_serve () const
+  {
+    return this->worker_serve_;
+  }
+
+  inline bool b_options::
+  worker_serve_specified () const
+  {
+    return this->worker_serve_specified_;
+  }
+
+  inline const dir_path& b_options::
+  action_cache () const
+  {
+    return this->action_cache_;
+  }
+
+  inline bool b_options::
+  action_cache_specified () const
+  {
+    return this->action_cache_specified_;
+  }
+
   inline const bool& b_options::
   serial_stop () const
   {
@@ -170,6 +242,12 @@ namespace build2
     return this->no_diag_buffer_;
   }
 
+  inline const bool& b_options::
+  diag_reactor () const
+  {
+    return this->diag_reactor_;
+  }
+
   inline const bool& b_options::
   match_only () const
   {
@@ -182,6 +260,24 @@ namespace build2
     return this->load_only_;
   }
 
+  inline const bool& b_options::
+  target_arena () const
+  {
+    return this->target_arena_;
+  }
+
+  inline const bool& b_options::
+  fast_exit () const
+  {
+    return this->fast_exit_;
+  }
+
+  inline const bool& b_options::
+  futex_wait () const
+  {
+    return this->futex_wait_;
+  }
+
   inline const bool& b_options::
   no_external_modules () const
   {
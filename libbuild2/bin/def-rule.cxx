@@ -3,6 +3,8 @@
 
 #include <libbuild2/bin/def-rule.hxx>
 
+#include <cstring> // memcmp()
+
 #include <libbuild2/depdb.hxx>
 #include <libbuild2/scope.hxx>
 #include <libbuild2/target.hxx>
@@ -308,6 +310,251 @@ namespace build2
       }
     }
 
+    // Extract symbols from a COFF object file (regular or /bigobj) directly,
+    // without running dumpbin or nm, and classify them the same way as
+    // read_dumpbin() (if dumpbin is true) or read_posix_nm() would.
+    //
+    // Return false if this is not an object file that we can handle (for
+    // example, an LTO object file whose symbols are only known to the
+    // compiler), in which case the caller should fall back to running the
+    // tool. Throw io_error if unable to read the file.
+    //
+    static bool
+    read_coff (const path& f, bool dumpbin, symbols& syms)
+    {
+      string d;
+      {
+        ifdstream is (f, fdopen_mode::binary, ifdstream::badbit);
+
+        d.resize (static_cast<size_t> (fdstat (is.fd ()).size));
+        is.read (&d[0], static_cast<streamsize> (d.size ()));
+        is.close ();
+      }
+
+      const size_t n (d.size ());
+      const char* b (d.data ());
+
+      auto u16 = [b] (size_t o) -> uint16_t
+      {
+        const unsigned char* p (reinterpret_cast<const unsigned char*> (b + o));
+        return static_cast<uint16_t> (p[0] | p[1] << 8);
+      };
+
+      auto u32 = [b] (size_t o) -> uint32_t
+      {
+        const unsigned char* p (reinterpret_cast<const unsigned char*> (b + o));
+        return (static_cast<uint32_t> (p[0])       |
+                static_cast<uint32_t> (p[1]) << 8  |
+                static_cast<uint32_t> (p[2]) << 16 |
+                static_cast<uint32_t> (p[3]) << 24);
+      };
+
+      // File header. Besides the regular one, we recognize the /bigobj
+      // (ANON_OBJECT_HEADER_BIGOBJ) variant. Other anonymous objects (such
+      // as LTCG or import objects) are not handled.
+      //
+      static const unsigned char bigobj_id[16] = {
+        0xc7, 0xa1, 0xba, 0xd1, 0xee, 0xba, 0xa9, 0x4b,
+        0xaf, 0x20, 0xfa, 0xf6, 0x6a, 0xa4, 0xdc, 0xb8};
+
+      bool big;
+      size_t sec_n, sec_off, sym_n, sym_off, sym_size;
+
+      if (n >= 56 && u16 (0) == 0 && u16 (2) == 0xffff)
+      {
+        if (u16 (4) < 2 || memcmp (b + 12, bigobj_id, 16) != 0)
+          return false;
+
+        big = true;
+        sec_n = u32 (44);
+        sec_off = 56;
+        sym_off = u32 (48);
+        sym_n = u32 (52);
+        sym_size = 20;
+      }
+      else if (n >= 20)
+      {
+        switch (u16 (0)) // Machine.
+        {
+        case 0x014c: // i386
+        case 0x8664: // x86_64
+        case 0x01c4: // ARM (Thumb-2)
+        case 0xaa64: // ARM64
+        case 0xa641: // ARM64EC
+        case 0xa64e: // ARM64X
+          break;
+        default:
+          return false;
+        }
+
+        if (u16 (16) != 0) // Has optional header so not an object file.
+          return false;
+
+        big = false;
+        sec_n = u16 (2);
+        sec_off = 20;
+        sym_off = u32 (8);
+        sym_n = u32 (12);
+        sym_size = 18;
+      }
+      else
+        return false;
+
+      if (sec_off + sec_n * 40 > n || sym_off + sym_n * sym_size > n)
+        return false;
+
+      // The string table immediately follows the symbol table and starts
+      // with its size (which includes the size field itself).
+      //
+      size_t str_off (sym_off + sym_n * sym_size);
+      size_t str_n (str_off + 4 <= n ? u32 (str_off) : 0);
+
+      if (str_off + str_n > n)
+        return false;
+
+      // Return the name stored in the 8-byte short name field.
+      //
+      auto short_name = [] (const char* p) -> string
+      {
+        size_t i (0);
+        for (; i != 8 && p[i] != '\0'; ++i) ;
+        return string (p, i);
+      };
+
+      // Return the name stored in the string table at the specified offset.
+      //
+      auto long_name = [b, str_off, str_n] (size_t o) -> optional<string>
+      {
+        if (o < 4 || o >= str_n)
+          return nullopt;
+
+        const char* s (b + str_off + o);
+        size_t m (str_n - o);
+        size_t i (0);
+        for (; i != m && s[i] != '\0'; ++i) ;
+        return string (s, i);
+      };
+
+      // Section types, as dumpbin (first) and nm (second) would see them
+      // (see read_dumpbin() and read_posix_nm() for details).
+      //
+      vector<pair<char, char>> secs;
+      secs.reserve (sec_n);
+
+      for (size_t i (0); i != sec_n; ++i)
+      {
+        const char* p (b + sec_off + i * 40);
+
+        // Long section names are specified as /<offset> (or //<base64> for
+        // very large offsets, which we don't expect in object files).
+        //
+        optional<string> s;
+        if (p[0] == '/')
+        {
+          size_t o (0);
+          for (size_t j (1); j != 8 && p[j] != '\0'; ++j)
+          {
+            if (p[j] < '0' || p[j] > '9')
+              return false;
+
+            o = o * 10 + static_cast<size_t> (p[j] - '0');
+          }
+
+          if (!(s = long_name (o)))
+            return false;
+        }
+        else
+          s = short_name (p);
+
+        // LTO object files (GCC) contain the compiler's intermediate
+        // representation with the symbol table only available through the
+        // linker plugin.
+        //
+        if (s->compare (0, 9, ".gnu.lto_") == 0)
+          return false;
+
+        auto cmp = [&s] (const char* n, size_t l)
+        {
+          return (s->compare (0, l, n) == 0 &&
+                  (s->size () == l || (*s)[l] == '$'));
+        };
+
+        char dt (cmp (".rdata", 6) || cmp (".xdata", 6) ? 'R' :
+                 cmp (".bss", 4)                          ? 'B' : 'D');
+
+        uint32_t c (u32 (sec_off + i * 40 + 36)); // Characteristics.
+
+        char nt (c & 0x00000020 ? 'T' :                 // CNT_CODE
+                 c & 0x00000080 ? 'B' :                 // CNT_UNINITIALIZED
+                 c & 0x00000040 ? (c & 0x80000000       // CNT_INITIALIZED
+                                   ? 'D'                //   MEM_WRITE
+                                   : 'R') :
+                 '\0');
+
+        secs.emplace_back (dt, nt);
+      }
+
+      auto insert = [&syms] (char t, string&& s)
+      {
+        switch (t)
+        {
+        case 'D': syms.d.insert (move (s)); break;
+        case 'R': syms.r.insert (move (s)); break;
+        case 'B': syms.b.insert (move (s)); break;
+        case 'C': syms.c.insert (move (s)); break;
+        case 'T': syms.t.insert (move (s)); break;
+        }
+      };
+
+      for (size_t i (0); i < sym_n; ++i)
+      {
+        size_t o (sym_off + i * sym_size);
+        const char* p (b + o);
+
+        uint32_t val (u32 (o + 8));
+        int32_t  sec (big
+                      ? static_cast<int32_t> (u32 (o + 12))
+                      : static_cast<int16_t> (u16 (o + 12)));
+        uint16_t typ (u16 (o + (big ? 16 : 14)));
+        uint8_t  cls (static_cast<uint8_t> (p[big ? 18 : 16]));
+
+        i += static_cast<uint8_t> (p[big ? 19 : 17]); // Skip aux records.
+
+        // We can only export extern symbols (IMAGE_SYM_CLASS_EXTERNAL).
+        //
+        if (cls != 2)
+          continue;
+
+        optional<string> s (u32 (o) == 0
+                            ? long_name (u32 (o + 4))
+                            : short_name (p));
+        if (!s)
+          return false;
+
+        char t ('\0');
+        if (sec == 0) // Undefined.
+        {
+          if (val != 0)
+            t = 'C';
+        }
+        else if (dumpbin)
+        {
+          // Functions are marked as such in the symbol type (DT_FCN).
+          //
+          t = ((typ & 0x30) == 0x20 ? 'T'                      :
+               sec > 0 && static_cast<size_t> (sec) <= sec_n
+               ? secs[sec - 1].first                           : 'D');
+        }
+        else if (sec > 0 && static_cast<size_t> (sec) <= sec_n)
+          t = secs[sec - 1].second;
+
+        if (t != '\0')
+          insert (t, move (*s));
+      }
+
+      return true;
+    }
+
     static void
     write_win32_msvc (ostream& os, const symbols& syms, bool i386)
     {
@@ -515,6 +762,86 @@ namespace build2
       }
     }
 
+    // Extract symbols from an object file, first trying to read it directly
+    // and falling back to running nm/dumpbin (see perform_update() for the
+    // arguments setup).
+    //
+    static void
+    extract_symbols (context& ctx,
+                     const process_path& nm,
+                     cstrings args,
+                     bool dumpbin,
+                     const path& f,
+                     symbols& syms)
+    {
+      try
+      {
+        if (read_coff (f, dumpbin, syms))
+          return;
+      }
+      catch (const io_error& e)
+      {
+        fail << "unable to read " << f << ": " << e;
+      }
+
+      // Use a relative path for nicer diagnostics.
+      //
+      path rp (relative (f));
+
+      const char*& arg (*(args.end () - 2));
+      arg = rp.string ().c_str ();
+
+      if (verb >= 2)
+        print_process (args);
+
+      // Both dumpbin.exe and nm send their output to stdout. While nm sends
+      // diagnostics to stderr, dumpbin sends it to stdout together with the
+      // output. To keep things uniform we will buffer stderr in both cases.
+      //
+      process pr (
+        run_start (nm,
+                   args,
+                   0                       /* stdin */,
+                   -1                      /* stdout */,
+                   diag_buffer::pipe (ctx) /* stderr */));
+
+      // Note that while we read both streams until eof in the normal
+      // circumstances, we cannot use fdstream_mode::skip for the exception
+      // case on both of them: we may end up being blocked trying to read
+      // one stream while the process may be blocked writing to the other.
+      // So in case of an exception we only skip the diagnostics and close
+      // stdout hard. The latter should happen first so the order of the
+      // dbuf/is variables is important.
+      //
+      diag_buffer dbuf (ctx, args[0], pr, (fdstream_mode::non_blocking |
+                                           fdstream_mode::skip));
+
+      bool io (false);
+      try
+      {
+        ifdstream is (move (pr.in_ofd),
+                      fdstream_mode::non_blocking,
+                      ifdstream::badbit);
+
+        if (dumpbin)
+          read_dumpbin (dbuf, is, syms);
+        else
+          read_posix_nm (dbuf, is, syms);
+
+        is.close ();
+      }
+      catch (const io_error&)
+      {
+        // Presumably the child process failed so let run_finish() deal with
+        // that first.
+        //
+        io = true;
+      }
+
+      if (!run_finish_code (dbuf, args, pr, 1 /* verbosity */) || io)
+        fail << "unable to extract symbols from " << arg;
+    }
+
     bool def_rule::
     match (action a, target& t) const
     {
@@ -580,8 +907,8 @@ namespace build2
       switch (a)
       {
       case perform_update_id: return &perform_update;
-      case perform_clean_id:  return &perform_clean_depdb; // Standard clean.
-      default:                return noop_recipe;          // Configure update.
+      case perform_clean_id:  return &perform_clean;
+      default:                return noop_recipe; // Configure update.
       }
     }
 
@@ -623,9 +950,11 @@ namespace build2
 
       // Then the nm checksum.
       //
-      if (dd.expect (lid == "msvc"
-                     ? cast<string> (rs["bin.ld.checksum"])
-                     : cast<string> (rs["bin.nm.checksum"])) != nullptr)
+      const string& nmcs (lid == "msvc"
+                          ? cast<string> (rs["bin.ld.checksum"])
+                          : cast<string> (rs["bin.nm.checksum"]));
+
+      if (dd.expect (nmcs) != nullptr)
         l4 ([&]{trace << "linker mismatch forcing update of " << t;});
 
       // @@ TODO: track in depdb if making symbol filtering configurable.
@@ -718,7 +1047,7 @@ namespace build2
       args.push_back (nullptr); // Argument placeholder.
       args.push_back (nullptr);
 
-      const char*& arg (*(args.end () - 2));
+      bool dumpbin (lid == "msvc" || nid == "msvc");
 
       // We could print the prerequisite if it's a single obj{}/libu{} (with
       // the latter being the common case). But it doesn't feel like that's
@@ -729,66 +1058,205 @@ namespace build2
 
       // Extract symbols from each object file.
       //
-      symbols syms;
+      // Since normally only a few object files change between relinks, we
+      // cache the symbols of each object file (keyed by its path,
+      // modification time, and contents checksum) in the .syms file next to
+      // the output and only re-extract them for the changed object files.
+      // The cache is also invalidated if the rule or the tool change (see
+      // the header lines below).
+      //
+      // The modification time is the quick check: if it differs, then we
+      // compare the checksums before re-extracting (the object file could
+      // have been recompiled without changes).
+      //
+      // The checksum calculation and extraction are performed in parallel.
+      //
+      struct cache_entry
+      {
+        string  mtime;
+        string  checksum;
+        symbols syms;
+      };
+
+      struct object
+      {
+        const path&  file;
+        string       mtime;    // Timestamp count.
+        string       checksum; // Contents SHA256.
+        cache_entry* entry = nullptr;
+        symbols      syms;
+        bool         failed = false;
+
+        object (const path& f, string m): file (f), mtime (move (m)) {}
+      };
+
+      vector<object> obs;
+      obs.reserve (os.size ());
+
       for (const objs& o: os)
+        obs.emplace_back (
+          o.path (),
+          to_string (o.load_mtime ().time_since_epoch ().count ()));
+
+      path cp (tp + ".syms");
+
+      if (!ctx.dry_run)
       {
-        // Use a relative path for nicer diagnostics.
+        // The cache file format is line-oriented: the rule id and tool
+        // checksum followed by the per-object entries, each starting with
+        // the "@ <mtime> <checksum> <path>" line and followed by the
+        // "<type> <symbol>" lines (with type being one of D, R, B, C, T).
+        //
+        // Note that we ignore (and drop) any invalid cache.
         //
-        path rp (relative (o.path ()));
-        arg = rp.string ().c_str ();
+        map<string, cache_entry> cache;
+        try
+        {
+          if (file_exists (cp))
+          {
+            ifdstream is (cp, ifdstream::badbit);
 
-        if (verb >= 2)
-          print_process (args);
+            string l;
+            if (!eof (getline (is, l)) && l == rule_id_ &&
+                !eof (getline (is, l)) && l == nmcs)
+            {
+              symbols* ss (nullptr);
+              while (!eof (getline (is, l)))
+              {
+                size_t n (l.size ());
+
+                if (n < 3 || l[1] != ' ')
+                  throw invalid_argument ("invalid line");
+
+                if (l[0] == '@')
+                {
+                  size_t p1 (l.find (' ', 2));
+                  size_t p2 (p1 != string::npos
+                             ? l.find (' ', p1 + 1)
+                             : string::npos);
+
+                  if (p2 == string::npos)
+                    throw invalid_argument ("invalid object line");
+
+                  cache_entry& e (cache[string (l, p2 + 1)]);
+                  e.mtime.assign (l, 2, p1 - 2);
+                  e.checksum.assign (l, p1 + 1, p2 - p1 - 1);
+                  ss = &e.syms;
+                  continue;
+                }
+
+                if (ss == nullptr)
+                  throw invalid_argument ("symbol without object");
+
+                string s (l, 2);
+                switch (l[0])
+                {
+                case 'D': ss->d.insert (move (s)); break;
+                case 'R': ss->r.insert (move (s)); break;
+                case 'B': ss->b.insert (move (s)); break;
+                case 'C': ss->c.insert (move (s)); break;
+                case 'T': ss->t.insert (move (s)); break;
+                default: throw invalid_argument ("invalid symbol type");
+                }
+              }
+            }
 
-        if (ctx.dry_run)
-          continue;
+            is.close ();
+          }
+        }
+        catch (const std::exception& e)
+        {
+          l4 ([&]{trace << "ignoring symbols cache " << cp << ": " << e;});
+          cache.clear ();
+        }
 
-        // Both dumpbin.exe and nm send their output to stdout. While nm sends
-        // diagnostics to stderr, dumpbin sends it to stdout together with the
-        // output. To keep things uniform we will buffer stderr in both cases.
-        //
-        process pr (
-          run_start (nm,
-                     args,
-                     0                       /* stdin */,
-                     -1                      /* stdout */,
-                     diag_buffer::pipe (ctx) /* stderr */));
-
-        // Note that while we read both streams until eof in the normal
-        // circumstances, we cannot use fdstream_mode::skip for the exception
-        // case on both of them: we may end up being blocked trying to read
-        // one stream while the process may be blocked writing to the other.
-        // So in case of an exception we only skip the diagnostics and close
-        // stdout hard. The latter should happen first so the order of the
-        // dbuf/is variables is important.
+        // Handle the objects that are not cached or whose modification time
+        // has changed in parallel. Note that similar to the test rule
+        // we use our own task count (we are busy executing).
         //
-        diag_buffer dbuf (ctx, args[0], pr, (fdstream_mode::non_blocking |
-                                             fdstream_mode::skip));
+        wait_guard wg (ctx, ctx.count_busy (), t[a].task_count);
 
-        bool io (false);
-        try
+        for (object& o: obs)
         {
-          ifdstream is (move (pr.in_ofd),
-                        fdstream_mode::non_blocking,
-                        ifdstream::badbit);
+          auto i (cache.find (o.file.string ()));
+          if (i != cache.end ())
+          {
+            cache_entry& e (i->second);
 
-          if (lid == "msvc" || nid == "msvc")
-            read_dumpbin (dbuf, is, syms);
-          else
-            read_posix_nm (dbuf, is, syms);
+            if (e.mtime == o.mtime)
+            {
+              o.checksum = move (e.checksum);
+              o.syms = move (e.syms);
+              continue;
+            }
+
+            o.entry = &e;
+          }
 
-          is.close ();
+          l5 ([&]{trace << "extracting symbols from " << o.file;});
+
+          ctx.sched->async (ctx.count_busy (),
+                            t[a].task_count,
+                            [] (const diag_frame* ds,
+                                context& ctx,
+                                const process_path& nm,
+                                const cstrings& args,
+                                bool dumpbin,
+                                object& o)
+                            {
+                              diag_frame::stack_guard dsg (ds);
+                              try
+                              {
+                                {
+                                  mapped_file mf (o.file);
+
+                                  sha256 cs;
+                                  cs.append (mf.data (), mf.size ());
+                                  o.checksum = cs.string ();
+                                }
+
+                                if (o.entry != nullptr &&
+                                    o.entry->checksum == o.checksum)
+                                {
+                                  o.syms = move (o.entry->syms);
+                                  return;
+                                }
+
+                                extract_symbols (
+                                  ctx, nm, args, dumpbin, o.file, o.syms);
+                              }
+                              catch (const failed&)
+                              {
+                                o.failed = true;
+                              }
+                            },
+                            diag_frame::stack (),
+                            ref (ctx),
+                            cref (nm),
+                            cref (args),
+                            dumpbin,
+                            ref (o));
         }
-        catch (const io_error&)
+
+        wg.wait ();
+
+        for (const object& o: obs)
         {
-          // Presumably the child process failed so let run_finish() deal with
-          // that first.
-          //
-          io = true;
+          if (o.failed)
+            throw failed ();
         }
+      }
 
-        if (!run_finish_code (dbuf, args, pr, 1 /* verbosity */) || io)
-          fail << "unable to extract symbols from " << arg;
+      // Merge.
+      //
+      symbols syms;
+      for (const object& o: obs)
+      {
+        syms.d.insert (o.syms.d.begin (), o.syms.d.end ());
+        syms.r.insert (o.syms.r.begin (), o.syms.r.end ());
+        syms.b.insert (o.syms.b.begin (), o.syms.b.end ());
+        syms.c.insert (o.syms.c.begin (), o.syms.c.end ());
+        syms.t.insert (o.syms.t.begin (), o.syms.t.end ());
       }
 
 #if 0
@@ -831,12 +1299,66 @@ namespace build2
         }
 
         dd.check_mtime (tp);
+
+        // Save the symbols cache. Note that if this fails, then the next
+        // update will simply re-extract all the symbols. To make sure a
+        // partially written cache is never seen, write it to a temporary
+        // file first and then move it into place.
+        //
+        path tcp (cp + ".tmp");
+        auto_rmfile rmc (tcp);
+        try
+        {
+          ofdstream os (tcp);
+
+          os << rule_id_ << '\n'
+             << nmcs << '\n';
+
+          for (const object& o: obs)
+          {
+            os << "@ " << o.mtime << ' ' << o.checksum << ' '
+               << o.file.string () << '\n';
+
+            auto write = [&os] (char c, const set<string>& ss)
+            {
+              for (const string& s: ss)
+                os << c << ' ' << s << '\n';
+            };
+
+            write ('D', o.syms.d);
+            write ('R', o.syms.r);
+            write ('B', o.syms.b);
+            write ('C', o.syms.c);
+            write ('T', o.syms.t);
+          }
+
+          os.close ();
+
+          butl::mvfile (tcp, cp,
+                        cpflags::overwrite_content |
+                        cpflags::overwrite_permissions);
+          rmc.cancel ();
+        }
+        catch (const io_error& e)
+        {
+          warn << "unable to write to " << tcp << ": " << e;
+        }
+        catch (const system_error& e)
+        {
+          warn << "unable to move " << tcp << " to " << cp << ": " << e;
+        }
       }
 
       t.mtime (system_clock::now ());
       return target_state::changed;
     }
 
+    target_state def_rule::
+    perform_clean (action a, const target& t)
+    {
+      return perform_clean_extra (a, t.as<file> (), {".d", ".syms"});
+    }
+
     const string def_rule::rule_id_ {"bin.def 2"};
   }
 }
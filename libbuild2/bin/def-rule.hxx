@@ -32,6 +32,9 @@ namespace build2
       static target_state
       perform_update (action, const target&);
 
+      static target_state
+      perform_clean (action, const target&);
+
     private:
       static const string rule_id_;
     };
@@ -244,6 +244,9 @@ namespace build2
         vp["cc.module_name"],
         vp["cc.importable"],
         vp["cc.reprocess"],
+        vp["cc.direct"],
+        vp["cc.header_unit_cache"],
+        vp["cc.lto_jobs"],
 
         vp.insert<string>   ("c.preprocessed"), // See cxx.preprocessed.
         nullptr,                                // No __symexport (no modules).
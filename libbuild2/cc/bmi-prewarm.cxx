@@ -0,0 +1,54 @@
+// file      : libbuild2/cc/bmi-prewarm.cxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#include <libbuild2/cc/bmi-prewarm.hxx>
+
+#ifndef _WIN32
+#  include <fcntl.h> // posix_fadvise()
+#endif
+
+using namespace std;
+using namespace butl;
+
+namespace build2
+{
+  namespace cc
+  {
+    bmi_prewarm prewarm_bmi;
+
+    void bmi_prewarm::
+    operator() (const path& f, timestamp mt)
+    {
+#ifdef POSIX_FADV_WILLNEED
+      if (mt == timestamp_unknown || mt == timestamp_nonexistent)
+        return;
+
+      {
+        slock l (mutex_);
+
+        auto i (map_.find (f));
+        if (i != map_.end () && i->second == mt)
+          return;
+      }
+
+      // Note that closing the file does not cancel the read-ahead.
+      //
+      try
+      {
+        auto_fd fd (fdopen (f, fdopen_mode::in | fdopen_mode::binary));
+        posix_fadvise (fd.get (), 0, 0, POSIX_FADV_WILLNEED);
+      }
+      catch (const system_error&)
+      {
+        return; // Let the compiler diagnose it.
+      }
+
+      ulock l (mutex_);
+      map_[f] = mt;
+#else
+      (void) f;
+      (void) mt;
+#endif
+    }
+  }
+}
@@ -0,0 +1,55 @@
+// file      : libbuild2/cc/bmi-prewarm.hxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#ifndef LIBBUILD2_CC_BMI_PREWARM_HXX
+#define LIBBUILD2_CC_BMI_PREWARM_HXX
+
+#include <libbuild2/types.hxx>
+#include <libbuild2/utility.hxx>
+
+#include <libbuild2/cc/export.hxx>
+
+namespace build2
+{
+  namespace cc
+  {
+    // Page cache pre-warming of imported BMIs.
+    //
+    // Each compilation that imports modules reads the BMIs of all the modules
+    // it imports, directly or indirectly. Commonly imported BMIs (std, a
+    // project's core modules, etc) are therefore read by many concurrent
+    // compiler processes. If such a BMI is not in the page cache (it was
+    // installed or built by a previous invocation a while ago), then every
+    // compiler that imports it blocks on reading it.
+    //
+    // Instead, before starting the compiler we ask the kernel to read the
+    // BMIs ahead asynchronously (posix_fadvise(POSIX_FADV_WILLNEED)) so that
+    // this overlaps with the compiler startup. The set of pre-warmed BMIs is
+    // process-wide (and thus shared between contexts) and is keyed by the
+    // BMI path and modification time. As a result, each version of a BMI is
+    // pre-warmed once rather than once per importer.
+    //
+    // Note that this is a hint and any errors are ignored. On platforms
+    // without posix_fadvise() this is a noop.
+    //
+    // MT-safe.
+    //
+    class LIBBUILD2_CC_SYMEXPORT bmi_prewarm
+    {
+    public:
+      // Pre-warm the BMI with the specified path (which should be absolute
+      // and normalized) and modification time unless already done.
+      //
+      void
+      operator() (const path&, timestamp);
+
+    private:
+      map<path, timestamp> map_;
+      mutable shared_mutex mutex_;
+    };
+
+    LIBBUILD2_CC_SYMEXPORT extern bmi_prewarm prewarm_bmi;
+  }
+}
+
+#endif // LIBBUILD2_CC_BMI_PREWARM_HXX
@@ -11,6 +11,7 @@
 #include <libbuild2/diagnostics.hxx>
 
 #include <libbuild2/cc/utility.hxx>
+#include <libbuild2/cc/library-index.hxx>
 
 using namespace std;
 using namespace butl;
@@ -846,20 +847,31 @@ namespace build2
       //
       // Note that normally we will have a handful of libraries repeated a
       // large number of times (see Boost for an extreme example of this).
+      // But projects with hundreds of imports are not unheard of either,
+      // which is why the cache is hashed rather than searched linearly.
       //
       // Note also that for non-utility libraries we know that only the link
       // order from linfo is used. While not caching it and always picking an
       // alternative could also work, we cache it to avoid the lookup.
       //
+      size_t h (0);
       if (cache != nullptr)
       {
         if (!q &&
             (cn.dir.absolute () && cn.dir.normalized ()) &&
             (out.empty () || (out.absolute () && out.normalized ())))
         {
-          auto i (find_if (cache->begin (), cache->end (),
-                           [lo, &cn, &out] (const library_cache_entry& e)
+          h = combine_hash (lo ? static_cast<size_t> (*lo) + 1 : 0,
+                            hash<string> () (cn.value),
+                            hash<string> () (cn.type),
+                            hash<dir_path> () (cn.dir),
+                            hash<dir_path> () (out));
+
+          auto r (cache->equal_range (h));
+          auto i (find_if (r.first, r.second,
+                           [lo, &cn, &out] (const library_cache::value_type& v)
                            {
+                             const library_cache_entry& e (v.second);
                              const target& t (e.lib);
                              return (e.lo == lo &&
                                      e.value == cn.value &&
@@ -868,8 +880,11 @@ namespace build2
                                      t.out == out);
                            }));
 
-          if (i != cache->end ())
-            return pair<const mtime_target&, const target*> {i->lib, i->group};
+          if (i != r.second)
+          {
+            const library_cache_entry& e (i->second);
+            return pair<const mtime_target&, const target*> {e.lib, e.group};
+          }
         }
         else
           cache = nullptr; // Do not cache.
@@ -924,7 +939,7 @@ namespace build2
       auto& t (xt->as<mtime_target> ());
 
       if (cache != nullptr)
-        cache->push_back (library_cache_entry {lo, cn.type, cn.value, t, g});
+        cache->emplace (h, library_cache_entry {lo, cn.type, cn.value, t, g});
 
       return pair<const mtime_target&, const target*> {t, g};
     }
@@ -1087,9 +1102,9 @@ namespace build2
         //
         if (!sn.empty ())
         {
-          f = d;
-          f /= sn;
-          mt = mtime (f);
+          mt = (lib_index->find (d, sn.string (), f)
+                ? mtime (f)
+                : timestamp_nonexistent);
 
           if (mt != timestamp_nonexistent)
           {
@@ -1140,7 +1155,9 @@ namespace build2
             //
             se = string ("dll");
             f = f.base (); // Remove .a from .dll.a.
-            mt = mtime (f);
+            mt = (lib_index->find (d, f.leaf ().string ())
+                  ? mtime (f)
+                  : timestamp_nonexistent);
 
             if (mt != timestamp_nonexistent)
             {
@@ -1156,10 +1173,8 @@ namespace build2
         //
         if (!an.empty () && (s != nullptr || tsys != "win32-msvc"))
         {
-          f = d;
-          f /= an;
-
-          if ((mt = mtime (f)) != timestamp_nonexistent)
+          if (lib_index->find (d, an.string (), f) &&
+              (mt = mtime (f)) != timestamp_nonexistent)
           {
             // Enter the target. Note that because the search paths are
             // normalized, the result is automatically normalized as well.
@@ -117,6 +117,9 @@ namespace build2
       const variable& c_module_name;  // cc.module_name
       const variable& c_importable;   // cc.importable
       const variable& c_reprocess;    // cc.reprocess
+      const variable& c_direct;       // cc.direct
+      const variable& c_hu_cache;     // cc.header_unit_cache
+      const variable& c_lto_jobs;     // cc.lto_jobs
 
       const variable& x_preprocessed; // x.preprocessed
       const variable* x_symexport;    // x.features.symexport
@@ -322,11 +325,18 @@ namespace build2
             x_hdr (hdr), x_inc (inc) {}
     };
 
+    class library_index;
+
     class LIBBUILD2_CC_SYMEXPORT common: public data
     {
     public:
       common (data&& d): data (move (d)) {}
 
+      // Library search directory index (see library-index.hxx). Set by the
+      // module to the context-global instance.
+      //
+      library_index* lib_index = nullptr;
+
       // Library handling.
       //
     public:
@@ -339,7 +349,11 @@ namespace build2
         const target*                         group;
       };
 
-      using library_cache = small_vector<library_cache_entry, 32>;
+      // Resolved library cache (see resolve_library()) keyed by the hash of
+      // the lookup key (link order, name, and out directory).
+      //
+      using library_cache = std::unordered_multimap<size_t,
+                                                    library_cache_entry>;
 
       // The prerequisite_target::include bit that indicates a library
       // member has been picked from the group.
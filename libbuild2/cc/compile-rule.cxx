@@ -15,9 +15,11 @@
 #include <libbuild2/context.hxx>
 #include <libbuild2/variable.hxx>
 #include <libbuild2/algorithm.hxx>
-#include <libbuild2/filesystem.hxx>  // mtime()
+#include <libbuild2/filesystem.hxx>  // mtime(), mapped_file
 #include <libbuild2/diagnostics.hxx>
 #include <libbuild2/make-parser.hxx>
+#include <libbuild2/worker-pool.hxx>
+#include <libbuild2/action-cache.hxx>
 
 #include <libbuild2/bin/target.hxx>
 
@@ -25,6 +27,7 @@
 #include <libbuild2/cc/target.hxx>  // h
 #include <libbuild2/cc/module.hxx>
 #include <libbuild2/cc/utility.hxx>
+#include <libbuild2/cc/bmi-prewarm.hxx>
 
 using std::exit;
 using std::strlen;
@@ -245,6 +248,10 @@ namespace build2
       unit_type type;
       preprocessed pp = preprocessed::none;
       bool deferred_failure = false;        // Failure deferred to compilation.
+      bool direct = false;                  // Direct mode (cc.direct).
+      bool direct_extract = false;          // Extract headers during compile.
+      size_t direct_skip = 0;               // Headers already in depdb.
+      optional<depdb::reopen_state> ddr;    // Depdb to complete in update.
       bool symexport = false;               // Target uses __symexport.
       bool touch = false;                   // Target needs to be touched.
       timestamp mt = timestamp_unknown;     // Target timestamp.
@@ -253,6 +260,8 @@ namespace build2
       path dd;                              // Dependency database path.
       size_t header_units = 0;              // Number of imported header units.
       module_positions modules = {0, 0, 0}; // Positions of imported modules.
+      string hu_key;                        // Header unit cache key prefix.
+      string ac_key;                        // Action cache key prefix.
 
       const compile_rule& rule;
 
@@ -846,6 +855,52 @@ namespace build2
       }
     }
 
+    // Hash the preprocessor options except for the header search paths
+    // (see header_unit_cache_key() for details).
+    //
+    static void
+    append_header_unit_poptions (sha256& cs, const cstrings& os)
+    {
+      for (auto i (os.begin ()), e (os.end ()); i != e; ++i)
+      {
+        const char* o (*i);
+
+        // Skip the header search path options, including the directory if
+        // specified as a separate argument.
+        //
+        size_t n (0);
+        if (o[0] == '-' || o[0] == '/')
+        {
+          if (o[1] == 'I')
+            n = 2;
+          else if (strncmp (o + 1, "external:I", 10) == 0)
+            n = 11;
+          else if (o[0] == '-')
+          {
+            for (const char* p: {"-isystem", "-iquote", "-idirafter"})
+            {
+              size_t m (strlen (p));
+              if (strncmp (o, p, m) == 0)
+              {
+                n = m;
+                break;
+              }
+            }
+          }
+        }
+
+        if (n != 0)
+        {
+          if (o[n] == '\0' && i + 1 != e)
+            ++i;
+
+          continue;
+        }
+
+        cs.append (o);
+      }
+    }
+
     recipe compile_rule::
     apply (action a, target& xt) const
     {
@@ -1118,6 +1173,30 @@ namespace build2
           md.symexport = l ? cast<bool> (l) : symexport;
         }
 
+        // Figure out if we are compiling in the direct mode where instead of
+        // running the preprocessor to extract header dependencies we let the
+        // compiler write them as a byproduct of compilation (-MD) and record
+        // them in depdb afterwards. On subsequent updates we then check the
+        // recorded headers as usual and, if any of them have changed, skip
+        // straight to compilation.
+        //
+        // Because with this approach we only learn about the headers after
+        // the compilation, we cannot discover (and generate) any missing
+        // headers nor make sure the existing ones are up-to-date before they
+        // are used. Which is why this mode must be explicitly requested (with
+        // cc.direct) and is only safe for projects that don't have generated
+        // headers.
+        //
+        // We also lose the ability to detect ignorable changes (whitespaces,
+        // comments, etc) since that relies on the preprocessed output. And
+        // the mode is limited to non-modular translation units and GCC-class
+        // compilers (VC's /showIncludes is mixed with diagnostics).
+        //
+        md.direct = (cclass == compiler_class::gcc &&
+                     ut == unit_type::non_modular  &&
+                     !modules                      &&
+                     cast_false<bool> (t[c_direct]));
+
         // NOTE: see similar code in adhoc_buildscript_rule::apply().
 
         // Make sure the output directory exists.
@@ -1181,6 +1260,9 @@ namespace build2
           //
           cs.append (&md.pp, sizeof (md.pp));
 
+          if (md.direct)
+            cs.append (&md.direct, sizeof (md.direct));
+
           if (ut == unit_type::module_intf) // Note: still unrefined.
             cs.append (&md.symexport, sizeof (md.symexport));
 
@@ -1227,6 +1309,56 @@ namespace build2
 
           if (dd.expect (cs.string ()) != nullptr)
             l4 ([&]{trace << "options mismatch forcing update of " << t;});
+
+          // If we are building a header unit and the shared header unit BMI
+          // cache is enabled or a non-modular translation unit and the
+          // action cache is enabled, then start the key with everything that
+          // goes into depdb so far (the rest is added in perform_update(),
+          // see header_unit_cache_key() and action_cache_key() for details).
+          //
+          // Note that for cl.exe we cannot be sure the object file is the
+          // only output (/Zi, etc) so we don't use the action cache.
+          //
+          bool huc (ut == unit_type::module_header &&
+                    cast_null<dir_path> (t[c_hu_cache]) != nullptr);
+
+          bool acc (ut == unit_type::non_modular &&
+                    ctx.acache != nullptr      &&
+                    ctype != compiler_type::msvc);
+
+          if (huc || acc)
+          {
+            sha256 ks;
+            ks.append (rule_id);
+            ks.append (cast<string> (rs[x_checksum]));
+            ks.append (env_checksum);
+
+            if (huc)
+            {
+              // For the header unit BMI cache only hash the options that may
+              // affect the BMI, which excludes the (normally project-
+              // specific) header search paths (see header_unit_cache_key()
+              // for details).
+              //
+              if (md.pp != preprocessed::all)
+              {
+                cstrings ps;
+                append_options (ps, t, x_poptions);
+                append_options (ps, t, c_poptions);
+                append_library_options (ps, bs, a, t, li);
+                append_header_unit_poptions (ks, ps);
+              }
+
+              append_options (ks, t, c_coptions);
+              append_options (ks, t, x_coptions);
+              append_options (ks, cmode);
+            }
+            else
+              ks.append (cs.string ());
+
+            ks.append (src.path ().string ());
+            (huc ? md.hu_key : md.ac_key) = ks.string ();
+          }
         }
 
         // Finally the source file.
@@ -1330,7 +1462,14 @@ namespace build2
         // the header extraction phase (none of the module information should
         // be relevant).
         //
-        if (!md.deferred_failure)
+        // We also skip it if we are extracting headers during compilation in
+        // the direct mode: there is no module information to speak of and
+        // re-parsing would mean running the preprocessor, which is exactly
+        // what we are trying to avoid. Instead, an empty (that is, not to be
+        // relied upon) checksum is saved after compilation (see
+        // extract_headers_direct()).
+        //
+        if (!md.deferred_failure && !md.direct_extract)
         {
           optional<string> cs;
           if (string* l = dd.read ())
@@ -1488,11 +1627,25 @@ namespace build2
         // to keep re-validating the file on every subsequent dry-run as well
         // on the real run).
         //
-        if (u && dd.reading () && !ctx.dry_run)
-          dd.touch = timestamp_unknown;
+        // In the direct mode the rest of the database (header dependencies
+        // and so on) will be written after compilation.
+        //
+        // Note that in case of dry run we will have an incomplete (but valid)
+        // database which will be updated on the next non-dry run.
+        //
+        if (md.direct_extract && !ctx.dry_run)
+        {
+          md.ddr = dd.close_to_reopen ();
+          md.dd = md.ddr->path;
+        }
+        else
+        {
+          if (u && dd.reading () && !ctx.dry_run)
+            dd.touch = timestamp_unknown;
 
-        dd.close (false /* mtime_check */);
-        md.dd = move (dd.path);
+          dd.close (false /* mtime_check */);
+          md.dd = move (dd.path);
+        }
 
         // If the preprocessed output is suitable for compilation, then pass
         // it along.
@@ -3986,6 +4139,27 @@ namespace build2
             }
           }
         }
+        else if (md.direct)
+        {
+          // In the direct mode we extract the headers during compilation
+          // (see apply() for details). Note that the headers we have already
+          // seen in depdb (skip_count) are up-to-date and will appear exactly
+          // the same in the compiler output (see the restart logic above),
+          // so we keep them and only overwrite the rest.
+          //
+          if (dd.reading ())
+          {
+            dd.read ();  // Read the next line, if any.
+            dd.write (); // Mark it for overwriting.
+          }
+
+          update = true;
+          md.direct_extract = true;
+          md.direct_skip = skip_count;
+
+          l6 ([&]{trace << "deferring to compilation (direct)";});
+          return;
+        }
         else
         {
           try
@@ -4856,6 +5030,107 @@ namespace build2
       result.second = puse;
     }
 
+    // Complete the dependency database in the direct mode by saving the
+    // header dependencies that the compiler wrote to the specified file (see
+    // apply() for details).
+    //
+    // Analogous to the cache=false case in extract_headers() except that
+    // here we just save the paths without entering them as targets (which
+    // we cannot do during execute). Note that the cache=true case expects
+    // them to be normalized.
+    //
+    void compile_rule::
+    extract_headers_direct (const file& t,
+                            match_data& md,
+                            const path& f) const
+    {
+      tracer trace (x, "compile_rule::extract_headers_direct");
+
+      depdb dd (move (*md.ddr));
+      md.ddr = nullopt;
+
+      auto df = make_diag_frame (
+        [&t](const diag_record& dr)
+        {
+          if (verb != 0)
+            dr << info << "while extracting header dependencies for " << t;
+        });
+
+      ifdstream is (ifdstream::badbit);
+      try
+      {
+        is.open (f);
+      }
+      catch (const io_error& e)
+      {
+        fail << "unable to open file " << f << ": " << e;
+      }
+
+      location il (f, 1);
+
+      size_t skip (md.direct_skip);
+      bool first (true); // Source file.
+
+      make_parser make;
+
+      for (string l;; ++il.line) // Reuse the buffer.
+      {
+        if (eof (getline (is, l)))
+        {
+          if (make.state != make_parser::end)
+            fail (il) << "incomplete make dependency declaration";
+
+          break;
+        }
+
+        l6 ([&]{trace << "header dependency line '" << l << "'";});
+
+        size_t pos (0);
+        do
+        {
+          pair<make_parser::type, path> r (make.next (l, pos, il));
+
+          if (r.second.empty () || r.first == make_parser::type::target)
+            continue;
+
+          // Skip the source file.
+          //
+          if (first)
+          {
+            first = false;
+            continue;
+          }
+
+          // Skip until where we left off.
+          //
+          if (skip != 0)
+          {
+            --skip;
+            continue;
+          }
+
+          path& hp (r.second);
+
+          if (hp.relative ())
+            hp.complete ();
+
+          normalize_external (hp, "header");
+          dd.write (hp);
+        }
+        while (pos != l.size ());
+
+        if (make.state == make_parser::end)
+          break;
+      }
+
+      // Add the terminating blank line followed by the translation unit
+      // checksum, which we don't have (see apply() for details).
+      //
+      dd.expect ("");
+      dd.write (string ());
+      dd.close ();
+    }
+
     // Return the translation unit information (last argument) and its
     // checksum (result). If the checksum is empty, then it should not be
     // used.
@@ -5110,10 +5385,22 @@ namespace build2
 
         try
         {
+          // We don't need the checksum if we are forced to reprocess or for
+          // header units (see below) in which case the parser can use the
+          // faster, pre-scanning mode.
+          //
+          parser p;
+          bool cs (!reprocess && md.type != unit_type::module_header);
+
           if (args.empty ())
           {
             pr = process (process_exit (0)); // Successfully exited.
-            pr.in_ofd = fdopen (*sp, fdopen_mode::in);
+
+            // Parse the (preprocessed) source directly from memory, which
+            // saves on copying through the stream buffer.
+            //
+            mapped_file f (*sp);
+            p.parse (f.data (), f.size (), path_name (*sp), tu, cs);
           }
           else
           {
@@ -5128,17 +5415,16 @@ namespace build2
                           0, -1, -2,
                           nullptr, // CWD
                           env.empty () ? nullptr : env.data ());
-          }
 
-          // Use binary mode to obtain consistent positions.
-          //
-          ifdstream is (move (pr.in_ofd),
-                        fdstream_mode::binary | fdstream_mode::skip);
+            // Use binary mode to obtain consistent positions.
+            //
+            ifdstream is (move (pr.in_ofd),
+                          fdstream_mode::binary | fdstream_mode::skip);
 
-          parser p;
-          p.parse (is, path_name (*sp), tu);
+            p.parse (is, path_name (*sp), tu, cs);
 
-          is.close ();
+            is.close ();
+          }
 
           if (pr.wait ())
           {
@@ -5196,9 +5482,7 @@ namespace build2
             //
             // Also, don't use the checksum for header units since it ignores
             // preprocessor directives and may therefore cause us to ignore a
-            // change to an exported macro. @@ TODO: maybe we should add a
-            // flag to the parser not to waste time calculating the checksum
-            // in these cases.
+            // change to an exported macro.
             //
             return reprocess || ut == unit_type::module_header
               ? string ()
@@ -6787,6 +7071,161 @@ namespace build2
       }
     }
 
+    // Shared header unit BMI cache.
+    //
+    // Header units of the standard library and of large third-party
+    // libraries end up being built over and over again in every project and
+    // configuration. If the cc.header_unit_cache directory is specified, then
+    // we store the header unit BMIs there after building them and, when an
+    // equivalent header unit needs to be built in any project or
+    // configuration, copy its BMI from the cache instead of compiling.
+    //
+    // An entry is keyed by the compiler and environment checksums, the
+    // options that may affect the BMI, the header path, as well as the paths
+    // and content digests of all the headers it includes (see apply() for
+    // the first part).
+    //
+    // Note that the header search paths (-I, etc) are not part of the key:
+    // they are normally project-specific (which would prevent any sharing)
+    // and the headers they resolve to are already accounted for by the
+    // included header paths and digests. For the same reason we use content
+    // digests rather than modification times. The macros (-D, -U), however,
+    // are part of the key since they may affect the header content.
+    //
+    // Header units that import other header units or modules are not cached
+    // since their BMIs refer to other BMIs.
+    //
+    // Populating the cache is safe for concurrent use by multiple threads
+    // and build system processes: the entry is written into a temporary file
+    // that is then atomically renamed into place. Note also that we copy
+    // rather than hardlink the entry since the target's modification time
+    // must be independent of that of the entry. Entries are never removed
+    // (the cache can be cleaned up by removing the directory while nothing is
+    // being built).
+    //
+    static string
+    header_unit_cache_key (action a,
+                           const file& t,
+                           const compile_rule::match_data& md)
+    {
+      sha256 cs;
+      cs.append (md.hu_key);
+
+      for (const target* pt: t.prerequisite_targets[a])
+      {
+        if (pt == nullptr)
+          continue;
+
+        if (const file* f = pt->is_a<file> ())
+        {
+          const path& p (f->path ());
+          cs.append (p.string ());
+
+          // Note: must be the same digest as calculated by the action cache.
+          //
+          if (action_cache* ac = t.ctx.acache)
+            cs.append (ac->digest (p, f->load_mtime ()));
+          else
+          {
+            mapped_file mf (p);
+
+            sha256 ds;
+            ds.append (mf.data (), mf.size ());
+            cs.append (ds.string ());
+          }
+        }
+      }
+
+      return cs.string ();
+    }
+
+    // Complete the action cache key (see apply() for the first part) with
+    // the paths and content digests of all the headers the translation unit
+    // includes (and which are all prerequisite targets by now).
+    //
+    static string
+    action_cache_key (action a,
+                      const file& t,
+                      const compile_rule::match_data& md)
+    {
+      action_cache& ac (*t.ctx.acache);
+
+      sha256 cs;
+      cs.append (md.ac_key);
+
+      for (const target* pt: t.prerequisite_targets[a])
+      {
+        if (pt == nullptr)
+          continue;
+
+        if (const file* f = pt->is_a<file> ())
+        {
+          const path& p (f->path ());
+
+          cs.append (p.string ());
+          cs.append (ac.digest (p, f->load_mtime ()));
+        }
+      }
+
+      return cs.string ();
+    }
+
+    // Copy the entry into the target returning false if there is no such
+    // entry. Diagnose errors as warnings (the entry can be removed from
+    // under us, etc) and treat them as a cache miss.
+    //
+    static bool
+    fetch_header_unit (const dir_path& d, const string& k, const path& tp)
+    {
+      path cf (d / path (k));
+
+      try
+      {
+        if (!file_exists (cf))
+          return false;
+
+        cpfile (cf, tp, cpflags::overwrite_content);
+        return true;
+      }
+      catch (const system_error& e)
+      {
+        warn << "unable to copy " << cf << " to " << tp << ": " << e;
+        return false;
+      }
+    }
+
+    // Store the target as the entry unless it already exists. Diagnose
+    // errors as warnings.
+    //
+    static void
+    store_header_unit (const dir_path& d, const string& k, const path& tp)
+    {
+      static atomic<size_t> count (0);
+
+      path cf (d / path (k));
+      path tf (cf.string () + '.' +
+               to_string (process::current_id ()) + '.' +
+               to_string (count.fetch_add (1, memory_order_relaxed)) + ".tmp");
+
+      try
+      {
+        if (file_exists (cf))
+          return;
+
+        try_mkdir_p (d);
+
+        auto_rmfile rm (tf);
+        cpfile (tp, tf);
+        mvfile (tf, cf, cpflags::overwrite_content);
+        rm.cancel ();
+      }
+      catch (const system_error& e)
+      {
+        warn << "unable to store " << tp << " in header unit cache " << d
+             << ": " << e;
+      }
+    }
+
     target_state compile_rule::
     perform_update (action a, const target& xt, match_data& md) const
     {
@@ -6844,6 +7283,66 @@ namespace build2
 
       touch (ctx, md.dd, false, verb_never);
 
+      // Try to get the header unit BMI from the shared cache (see
+      // header_unit_cache_key() for details).
+      //
+      const dir_path* hcd (nullptr);
+      string hck;
+
+      if (!md.hu_key.empty ()     &&
+          md.header_units == 0    &&
+          md.modules.start == 0   &&
+          !md.deferred_failure    &&
+          !ctx.dry_run)
+      {
+        hcd = &cast<dir_path> (t[c_hu_cache]);
+        hck = header_unit_cache_key (a, t, md);
+
+        if (fetch_header_unit (*hcd, hck, tp))
+        {
+          if (verb >= 2)
+            text << "cp " << *hcd / path (hck) << ' ' << tp;
+          else if (verb)
+            print_diag ("cp", *hcd / path (hck), t);
+
+          timestamp now (system_clock::now ());
+          depdb::check_mtime (start, md.dd, tp, now);
+
+          t.mtime (now);
+          return target_state::changed;
+        }
+      }
+
+      // Similarly, try to get the object file from the action cache (see
+      // action_cache_key() for details). Note that if we extract the header
+      // dependencies while compiling, then we have to compile.
+      //
+      string ack;
+
+      if (!md.ac_key.empty ()    &&
+          !md.ddr                &&
+          md.header_units == 0   &&
+          md.modules.start == 0  &&
+          !md.deferred_failure   &&
+          !ctx.dry_run)
+      {
+        ack = action_cache_key (a, t, md);
+
+        if (ctx.acache->fetch (ack, paths {tp}))
+        {
+          if (verb >= 2)
+            text << "cp " << ctx.acache->entry (ack) << ' ' << tp;
+          else if (verb)
+            print_diag ("cp", ctx.acache->entry (ack), t);
+
+          timestamp now (system_clock::now ());
+          depdb::check_mtime (start, md.dd, tp, now);
+
+          t.mtime (now);
+          return target_state::changed;
+        }
+      }
+
       const scope& bs (t.base_scope ());
 
       otype ot (compile_type (t, ut));
@@ -6860,6 +7359,7 @@ namespace build2
       //
       path relm;
       path relo;
+      auto_rmfile drm; // Header dependency output in the direct mode.
       switch (ut)
       {
       case unit_type::module_header:
@@ -7232,6 +7732,21 @@ namespace build2
           append_header_options (env, args, header_args, a, t, md, md.dd);
           append_module_options (env, args, module_args, a, t, md, md.dd);
 
+          // In the direct mode write the header dependency information as a
+          // byproduct of compilation (see apply() for details).
+          //
+          // Use the .t extension (for "temporary"; .d is taken), the same
+          // as in extract_headers().
+          //
+          if (md.direct_extract)
+          {
+            drm = auto_rmfile (tp + ".t", !ctx.dry_run /* active */);
+
+            args.push_back ("-MD");
+            args.push_back ("-MF");
+            args.push_back (drm.path.string ().c_str ());
+          }
+
           // Note: the order of the following options is relied upon below.
           //
           out_i = args.size (); // Index of the -o option.
@@ -7458,29 +7973,77 @@ namespace build2
           //
           bool filter (ctype == compiler_type::msvc);
 
-          process pr (cpath,
-                      args,
-                      0, 2, diag_buffer::pipe (ctx, filter /* force */),
-                      nullptr, // CWD
-                      env.empty () ? nullptr : env.data ());
-
-          diag_buffer dbuf (ctx, args[0], pr);
-
-          if (filter)
-            msvc_filter_cl (dbuf, *sp);
-
-          dbuf.read ();
+          // Start reading the imported BMIs ahead (see bmi_prewarm for
+          // details).
+          //
+          if (md.modules.start != 0)
+          {
+            auto& pts (t.prerequisite_targets[a]);
+            for (size_t i (md.modules.start); i != pts.size (); ++i)
+            {
+              if (const target* pt = pts[i])
+              {
+                const file& f (pt->as<file> ());
+                prewarm_bmi (f.path (), f.mtime ());
+              }
+            }
+          }
 
-          // Restore the original source if we switched to preprocessed.
+          // Execute through the worker pool, if any (see worker_pool for
+          // details). Note that we need the output filtering for cl.exe so
+          // we always run it ourselves.
           //
-          if (psrc)
+          if (ctx.workers != nullptr && !filter)
           {
-            args.resize (osrc.first);
-            args.push_back (osrc.second);
-            args.push_back (nullptr);
+            worker_pool::result r (
+              ctx.workers->execute (*ctx.sched,
+                                    cpath,
+                                    args.data (),
+                                    env.empty () ? nullptr : env.data (),
+                                    strings {sp->string ()},
+                                    strings {tp.string ()}));
+
+            diag_buffer dbuf (ctx, move (r.output));
+            dbuf.open_eof (args[0]);
+
+            if (psrc)
+            {
+              args.resize (osrc.first);
+              args.push_back (osrc.second);
+              args.push_back (nullptr);
+            }
+
+            dbuf.close (args, r.exit, 1 /* verbosity */);
+
+            if (!r.exit)
+              throw failed ();
           }
+          else
+          {
+            process pr (cpath,
+                        args,
+                        0, 2, diag_buffer::pipe (ctx, filter /* force */),
+                        nullptr, // CWD
+                        env.empty () ? nullptr : env.data ());
+
+            diag_buffer dbuf (ctx, args[0], pr);
+
+            if (filter)
+              msvc_filter_cl (dbuf, *sp);
 
-          run_finish (dbuf, args, pr, 1 /* verbosity */);
+            dbuf.read ();
+
+            // Restore the original source if we switched to preprocessed.
+            //
+            if (psrc)
+            {
+              args.resize (osrc.first);
+              args.push_back (osrc.second);
+              args.push_back (nullptr);
+            }
+
+            run_finish (dbuf, args, pr, 1 /* verbosity */);
+          }
         }
         catch (const process_error& e)
         {
@@ -7494,6 +8057,9 @@ namespace build2
 
         if (md.deferred_failure)
           fail << "expected error exit status from " << x_lang << " compiler";
+
+        if (md.ddr)
+          extract_headers_direct (t, md, drm.path);
       }
 
       // Remove preprocessed file (see above).
@@ -7554,6 +8120,12 @@ namespace build2
         }
       }
 
+      if (hcd != nullptr)
+        store_header_unit (*hcd, hck, tp);
+
+      if (!ack.empty ())
+        ctx.acache->store (ack, paths {tp});
+
       timestamp now (system_clock::now ());
 
       if (!ctx.dry_run)
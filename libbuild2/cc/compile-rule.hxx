@@ -136,6 +136,9 @@ namespace build2
                        depdb&, bool&, timestamp, module_imports&,
                        pair<file_cache::entry, bool>&) const;
 
+      void
+      extract_headers_direct (const file&, match_data&, const path&) const;
+
       string
       parse_unit (action, file&, linfo,
                   const file&, file_cache::entry&,
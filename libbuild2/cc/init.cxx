@@ -180,6 +180,28 @@ namespace build2
       vp.insert<bool> ("config.cc.reprocess");
       vp.insert<bool> ("cc.reprocess");
 
+      // Ability to extract header dependencies as a byproduct of compilation
+      // rather than with a separate preprocessor run. Only safe for projects
+      // that don't have any generated headers (see compile_rule::apply() for
+      // details).
+      //
+      vp.insert<bool> ("config.cc.direct");
+      vp.insert<bool> ("cc.direct");
+
+      // Directory of the header unit BMI cache that can be shared between
+      // projects and configurations (see compile_rule::perform_update() for
+      // details).
+      //
+      vp.insert<dir_path> ("config.cc.header_unit_cache");
+      vp.insert<dir_path> ("cc.header_unit_cache");
+
+      // Maximum number of threads (including the linking thread) that an LTO
+      // link may use, 0 meaning all the currently available threads (see
+      // link_rule::perform_update() for details).
+      //
+      vp.insert<uint64_t> ("config.cc.lto_jobs");
+      vp.insert<uint64_t> ("cc.lto_jobs");
+
       // Register scope operation callback.
       //
       // It feels natural to clean up sidebuilds as a post operation but that
@@ -337,6 +359,34 @@ namespace build2
       if (lookup l = lookup_config (rs, "config.cc.reprocess"))
         rs.assign ("cc.reprocess") = *l;
 
+      // config.cc.direct
+      //
+      // Note: save omitted.
+      //
+      if (lookup l = lookup_config (rs, "config.cc.direct"))
+        rs.assign ("cc.direct") = *l;
+
+      // config.cc.header_unit_cache
+      //
+      // Note: save omitted.
+      //
+      if (lookup l = lookup_config (rs, "config.cc.header_unit_cache"))
+      {
+        dir_path d (cast<dir_path> (l));
+
+        if (d.relative ())
+          fail << "relative directory in config.cc.header_unit_cache: " << d;
+
+        rs.assign ("cc.header_unit_cache") = move (d.normalize ());
+      }
+
+      // config.cc.lto_jobs
+      //
+      // Note: save omitted.
+      //
+      if (lookup l = lookup_config (rs, "config.cc.lto_jobs"))
+        rs.assign ("cc.lto_jobs") = *l;
+
       // Load the bin.config module.
       //
       if (!cast_false<bool> (rs["bin.config.loaded"]))
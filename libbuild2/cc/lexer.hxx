@@ -86,7 +86,7 @@ namespace build2
     class lexer: protected butl::char_scanner<>
     {
     public:
-      lexer (ifdstream& is, const path_name& name)
+      lexer (istream& is, const path_name& name)
           : char_scanner (is, false /* crlf */),
             name_ (name),
             fail ("error", &name_),
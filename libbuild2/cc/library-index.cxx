@@ -0,0 +1,102 @@
+// file      : libbuild2/cc/library-index.cxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#include <libbuild2/cc/library-index.hxx>
+
+#include <libbuild2/context.hxx>
+
+#include <libbutl/filesystem.hxx> // dir_iterator, dir_mtime()
+
+using namespace std;
+using namespace butl;
+
+namespace build2
+{
+  namespace cc
+  {
+    static inline string
+    index_name (const string& n)
+    {
+#if defined(_WIN32) || defined(__APPLE__)
+      return lcase (n);
+#else
+      return n;
+#endif
+    }
+
+    library_index& library_index::
+    instance (context& ctx)
+    {
+      static const char key ('\0');
+
+      using data_ptr = context::current_data_ptr;
+
+      return *static_cast<library_index*> (
+        ctx.module_data (
+          &key,
+          [] ()
+          {
+            return data_ptr (new library_index,
+                             [] (void* p)
+                             {
+                               delete static_cast<library_index*> (p);
+                             });
+          }));
+    }
+
+    bool library_index::
+    find (const dir_path& d, const string& n)
+    {
+      shared_ptr<const entry> e;
+      {
+        slock l (mutex_);
+
+        auto i (map_.find (d));
+        if (i != map_.end ())
+          e = i->second;
+      }
+
+      if (e == nullptr)
+      {
+        // Note that we don't bother preventing several threads from scanning
+        // the same directory simultaneously: this should be rare and the
+        // result is the same.
+        //
+        timestamp start (system_clock::now ());
+
+        timestamp mt;
+        entry ne;
+        try
+        {
+          mt = dir_mtime (d);
+
+          if (mt != timestamp_nonexistent)
+          {
+            for (const dir_entry& de:
+                   dir_iterator (d, dir_iterator::no_follow))
+              ne.insert (index_name (de.path ().string ()));
+          }
+        }
+        catch (const system_error&)
+        {
+          return true; // Let the caller verify (and diagnose) it.
+        }
+
+        e = make_shared<const entry> (move (ne));
+
+        // Only cache the result if the directory was not modified recently
+        // (see the class description for details). Note that we allow for a
+        // coarse (up to two seconds, as on FAT) filesystem timestamp
+        // resolution.
+        //
+        if (mt == timestamp_nonexistent || mt + chrono::seconds (2) < start)
+        {
+          ulock l (mutex_);
+          map_.emplace (d, e);
+        }
+      }
+
+      return e->find (index_name (n)) != e->end ();
+    }
+  }
+}
@@ -0,0 +1,83 @@
+// file      : libbuild2/cc/library-index.hxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#ifndef LIBBUILD2_CC_LIBRARY_INDEX_HXX
+#define LIBBUILD2_CC_LIBRARY_INDEX_HXX
+
+#include <unordered_set>
+
+#include <libbuild2/types.hxx>
+#include <libbuild2/forward.hxx>
+#include <libbuild2/utility.hxx>
+
+#include <libbuild2/cc/export.hxx>
+
+namespace build2
+{
+  namespace cc
+  {
+    // Index of library search directory entries.
+    //
+    // Searching for installed libraries (search_library(),
+    // find_system_library(), pkgconfig_search()) boils down to probing each
+    // library directory for a number of names (lib<name>.so, lib<name>.a,
+    // lib<name>.pc, etc), most of which do not exist. And this is repeated
+    // for every imported library in every project. Instead, we scan each
+    // directory once (with a single readdir pass) and answer such probes
+    // with a hash lookup.
+    //
+    // The index is context-global (and thus shared between all the projects
+    // in a context, see instance() below) and each directory is scanned (and
+    // its modification time checked) once per context. In other words, we
+    // assume that library directories do not change during the build.
+    // However, a directory that was modified during the scan (or, more
+    // precisely, whose modification time is not older than the scan start)
+    // is not cached since we cannot be sure we have seen all its entries and
+    // is rescanned on the next lookup.
+    //
+    // Note that on filesystems that are (or may be) case-insensitive, entry
+    // names are stored and looked up in lower case which means the lookup
+    // may yield false positives. As a result, an entry found in the index
+    // should still be verified, which normally has to be done anyway to
+    // obtain its modification time. Any errors during the scan are also
+    // treated as "may exist".
+    //
+    // MT-safe.
+    //
+    class LIBBUILD2_CC_SYMEXPORT library_index
+    {
+    public:
+      // Return the index of the specified context, creating it if
+      // necessary.
+      //
+      static library_index&
+      instance (context&);
+
+      // Return false if the specified directory (which should be absolute and
+      // normalized) definitely does not contain an entry with the specified
+      // name (which should be a simple path).
+      //
+      bool
+      find (const dir_path&, const string&);
+
+      // As above but also set the path buffer to the entry path (which is
+      // done regardless of the outcome).
+      //
+      bool
+      find (const dir_path& d, const string& n, path& f)
+      {
+        f = d;
+        f /= n;
+        return find (d, n);
+      }
+
+    private:
+      using entry = std::unordered_set<string>; // See index_name().
+
+      map<dir_path, shared_ptr<const entry>> map_;
+      mutable shared_mutex mutex_;
+    };
+  }
+}
+
+#endif // LIBBUILD2_CC_LIBRARY_INDEX_HXX
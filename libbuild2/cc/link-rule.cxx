@@ -15,6 +15,8 @@
 #include <libbuild2/algorithm.hxx>
 #include <libbuild2/filesystem.hxx>
 #include <libbuild2/diagnostics.hxx>
+#include <libbuild2/jobserver.hxx>
+#include <libbuild2/action-cache.hxx>
 
 #include <libbuild2/bin/rule.hxx>    // lib_rule::build_members()
 #include <libbuild2/bin/target.hxx>
@@ -24,6 +26,7 @@
 
 #include <libbuild2/cc/target.hxx>  // c, pc*
 #include <libbuild2/cc/utility.hxx>
+#include <libbuild2/cc/library-index.hxx>
 
 using std::exit;
 
@@ -239,11 +242,12 @@ namespace build2
       path p; // Reuse the buffer.
       for (const dir_path& d: sys_lib_dirs)
       {
-        auto exists = [&p, &d] (const string& n)
+        auto exists = [&p, &d, this] (const string& n)
         {
-          return file_exists ((p = d, p /= n),
-                              true /* follow_symlinks */,
-                              true /* ignore_errors */);
+          return (lib_index->find (d, n, p) &&
+                  file_exists (p,
+                               true /* follow_symlinks */,
+                               true /* ignore_errors */));
         };
 
         if (exists (n1) || (!n2.empty () && exists (n2)))
@@ -2123,7 +2127,8 @@ namespace build2
                       const scope& bs, action a,
                       const file& l, bool la, lflags lf, linfo li,
                       optional<bool> for_install, bool self, bool rel,
-                      library_cache* lib_cache) const
+                      library_cache* lib_cache,
+                      vector<const file*>* inputs) const
     {
       struct data
       {
@@ -2135,6 +2140,7 @@ namespace build2
 
         bool*                update;
         timestamp            mt;
+        vector<const file*>* inputs;
 
         const file&          l;
         action               a;
@@ -2144,7 +2150,7 @@ namespace build2
         compile_target_types tts;
       } d {ls, args,
            cs, cs != nullptr ? &bs.root_scope ()->out_path () : nullptr,
-           update, mt,
+           update, mt, inputs,
            l, a, li, for_install, rel, compile_types (li.type)};
 
       auto imp = [] (const target&, bool la)
@@ -2287,11 +2293,15 @@ namespace build2
             if (l->mtime () == timestamp_unreal) // Binless.
               goto done;
 
-            // Check if this library renders us out of date.
+            // Check if this library renders us out of date (or arrange for
+            // this to be checked later).
             //
             if (d.update != nullptr)
               *d.update = *d.update || l->newer (d.mt);
 
+            if (d.inputs != nullptr)
+              d.inputs->push_back (l);
+
             for (const target* pt: l->prerequisite_targets[d.a])
             {
               if (pt == nullptr)
@@ -2326,11 +2336,15 @@ namespace build2
             if (l->mtime () == timestamp_unreal) // Binless.
               goto done;
 
-            // Check if this library renders us out of date.
+            // Check if this library renders us out of date (or arrange for
+            // this to be checked later).
             //
             if (d.update != nullptr)
               *d.update = *d.update || l->newer (d.mt);
 
+            if (d.inputs != nullptr)
+              d.inputs->push_back (l);
+
             // On Windows a shared library is a DLL with the import library as
             // an ad hoc group member. MinGW though can link directly to DLLs
             // (see search_library() for details).
@@ -2436,6 +2450,215 @@ namespace build2
                          lib_cache);
     }
 
+    const link_rule::library_closure& link_rule::
+    find_library_closure (const scope& bs, action a,
+                          const file& l, bool la, lflags lf, linfo li,
+                          optional<bool> for_install,
+                          library_cache* lib_cache) const
+    {
+      // Note that the result depends on the base scope (see
+      // process_libraries() for details) and on the rule itself (target
+      // system, etc), which is why we keep the closures in the rule.
+      //
+      library_closure_key k {&l, &bs, a, lf, li, la, for_install};
+
+      {
+        slock sl (closures_mutex_);
+
+        auto i (closures_.find (k));
+        if (i != closures_.end ())
+          return i->second;
+      }
+
+      // Calculate outside the lock. If someone beats us to it, then we
+      // discard ours (both are the same).
+      //
+      library_closure c;
+      {
+        appended_libraries als;
+        sha256 cs;
+
+        append_libraries (als, c.args,
+                          &cs, nullptr, timestamp_unknown,
+                          bs, a, l, la, lf, li,
+                          for_install, true, true, lib_cache, &c.inputs);
+
+        c.libs.assign (als.begin (), als.end ());
+        c.checksum = cs.string ();
+
+        for (size_t i (0); i != c.libs.size (); ++i)
+          c.index.emplace (appended_library_key (c.libs[i]), i);
+      }
+
+      ulock ul (closures_mutex_);
+      return closures_.emplace (move (k), move (c)).first->second;
+    }
+
+    // Return the key that identifies the library of an appended library
+    // entry: the target for a library target and the name otherwise (see
+    // appended_libraries::find() for details).
+    //
+    pair<const void*, string> link_rule::
+    appended_library_key (const appended_library& al)
+    {
+      if (al.l2 == nullptr)
+        return make_pair (al.l1, string ());
+
+      string n (*static_cast<const string*> (al.l2));
+
+      if (al.l1 != nullptr)
+      {
+        n += '\0';
+        n += *static_cast<const string*> (al.l1);
+      }
+
+      return make_pair (nullptr, move (n));
+    }
+
+    // Append the library closure with the same result (modulo the order of
+    // the options of binless libraries) as if the closure's library was
+    // passed to append_libraries() but without traversing the library graph
+    // and hoisting each duplicate one by one.
+    //
+    // Specifically, append_libraries() moves each library it encounters to
+    // the end (either by appending or hoisting it). So the result is the
+    // libraries that are not in the closure in their original order followed
+    // by the closure in its own order. Note, however, that for a library
+    // that has already been appended we must keep its original arguments
+    // since it could have been appended with different flags (for example,
+    // whole archive).
+    //
+    void link_rule::
+    append_library_closure (appended_libraries& ls, strings& args,
+                            const library_closure& c) const
+    {
+      const size_t npos (appended_library::npos);
+      size_t n (c.libs.size ());
+
+      // Find the libraries from the closure that have already been appended,
+      // save their arguments, and remove them.
+      //
+      vector<optional<strings>> saved;
+
+      // Note that we look up each appended library in the closure index
+      // rather than each closure library in the list (which is a linear
+      // search).
+      //
+      if (!ls.empty () && n != 0)
+      {
+        vector<bool> rm;
+
+        for (appended_library& al: ls)
+        {
+          if (al.end == npos)
+            continue;
+
+          auto p (c.index.find (appended_library_key (al)));
+          if (p == c.index.end ())
+            continue;
+
+          size_t i (p->second);
+
+          if (saved.empty ())
+          {
+            saved.resize (n);
+            rm.resize (args.size (), false);
+          }
+
+          strings& sv (*(saved[i] = strings ()));
+          for (size_t j (al.begin); j != al.end; ++j)
+          {
+            sv.push_back (move (args[j]));
+            rm[j] = true;
+          }
+
+          al.begin = al.end = npos; // Mark for removal.
+        }
+
+        if (!saved.empty ())
+        {
+          // Compact the arguments recording the new position of each.
+          //
+          vector<size_t> pos (args.size () + 1);
+
+          size_t k (0);
+          for (size_t j (0); j != args.size (); ++j)
+          {
+            pos[j] = k;
+
+            if (!rm[j])
+            {
+              if (k != j)
+                args[k] = move (args[j]);
+
+              ++k;
+            }
+          }
+          pos[args.size ()] = k;
+          args.resize (k);
+
+          for (appended_library& al: ls)
+          {
+            if (al.begin != npos)
+            {
+              al.begin = pos[al.begin];
+              al.end = pos[al.end];
+            }
+          }
+
+          ls.erase (remove_if (ls.begin (), ls.end (),
+                               [npos] (const appended_library& al)
+                               {
+                                 return al.begin == npos;
+                               }),
+                    ls.end ());
+        }
+      }
+
+      // Append the closure arguments in order, substituting the saved
+      // arguments for the libraries that have been found.
+      //
+      vector<size_t> order (n);
+      for (size_t i (0); i != n; ++i)
+        order[i] = i;
+
+      sort (order.begin (), order.end (),
+            [&c] (size_t x, size_t y)
+            {
+              return c.libs[x].begin < c.libs[y].begin;
+            });
+
+      size_t j (0);
+      for (size_t i: order)
+      {
+        const appended_library& cl (c.libs[i]);
+
+        if (cl.end == npos) // Shouldn't happen but let's be safe.
+          continue;
+
+        for (; j < cl.begin; ++j) // Arguments of untracked libraries.
+          args.push_back (c.args[j]);
+
+        size_t b (args.size ());
+
+        if (!saved.empty () && saved[i])
+        {
+          for (string& a: *saved[i])
+            args.push_back (move (a));
+        }
+        else
+          args.insert (args.end (),
+                       c.args.begin () + cl.begin,
+                       c.args.begin () + cl.end);
+
+        j = cl.end;
+        ls.push_back (appended_library {cl.l1, cl.l2, b, args.size ()});
+      }
+
+      for (; j < c.args.size (); ++j)
+        args.push_back (c.args[j]);
+    }
+
     void link_rule::
     rpath_libraries (rpathed_libraries& ls, strings& args,
                      const scope& bs,
@@ -3440,6 +3663,19 @@ namespace build2
       //
       bool seen_obj (false);
       const file* def (nullptr); // Cached if present.
+
+      // If the action cache is enabled, then also collect the input files
+      // whose contents go into the action key (see below). We only cache
+      // executables and static libraries (shared libraries come with
+      // symlinks, import libraries, etc) and not on Windows (manifests,
+      // rpath-emulating assemblies, .pdb files, etc).
+      //
+      bool acc (ctx.acache != nullptr                      &&
+                (lt.executable () || lt.static_library ()) &&
+                tclass != "windows"                        &&
+                !ctx.dry_run);
+
+      vector<const file*> acins;
       {
         appended_libraries als;
         library_cache lc;
@@ -3491,10 +3727,38 @@ namespace build2
             //
             if (la || ls)
             {
-              append_libraries (als, sargs,
-                                &cs, &update, mt,
-                                bs, a, *f, la, p.data, li,
-                                for_install, true, true, &lc);
+              // When linking an executable or a shared library, use the
+              // memoized library closure (we don't bother for static
+              // libraries, which only link utility libraries).
+              //
+              if (li.type != otype::a)
+              {
+                const library_closure& c (
+                  find_library_closure (bs, a, *f, la, p.data, li,
+                                        for_install, &lc));
+
+                append_library_closure (als, sargs, c);
+                cs.append (c.checksum);
+
+                if (acc)
+                  acins.insert (acins.end (),
+                                c.inputs.begin (), c.inputs.end ());
+
+                for (const file* l: c.inputs)
+                {
+                  if (update)
+                    break;
+
+                  update = l->newer (mt);
+                }
+              }
+              else
+                append_libraries (als, sargs,
+                                  &cs, &update, mt,
+                                  bs, a, *f, la, p.data, li,
+                                  for_install, true, true, &lc,
+                                  acc ? &acins : nullptr);
+
               f = nullptr; // Timestamp checked by hash_libraries().
             }
             else
@@ -3508,6 +3772,9 @@ namespace build2
               sargs.push_back (relative (p).string ());
               hash_path (cs, p, rs.out_path ());
 
+              if (acc)
+                acins.push_back (f);
+
               // @@ Do we actually need to hash this? I don't believe this set
               // can change without rendering the object file itself out of
               // date. Maybe in some pathological case where the bmi*{} is
@@ -3575,6 +3842,45 @@ namespace build2
       if (!update)
         return ts;
 
+      // Try to get the target from the action cache. The action key is the
+      // depdb contents (which captures the linker, options, and the input
+      // file set) plus the content digests of all the inputs.
+      //
+      string ack;
+      if (acc)
+      {
+        action_cache& ac (*ctx.acache);
+
+        sha256 acs;
+        {
+          mapped_file mf (dd.path);
+          acs.append (mf.data (), mf.size ());
+        }
+
+        for (const file* f: acins)
+        {
+          const path& p (f->path ());
+
+          acs.append (p.string ());
+          acs.append (ac.digest (p, f->load_mtime ()));
+        }
+
+        ack = acs.string ();
+
+        if (ac.fetch (ack, paths {tp}))
+        {
+          if (verb >= 2)
+            text << "cp " << ac.entry (ack) << ' ' << tp;
+          else if (verb)
+            print_diag ("cp", ac.entry (ack), t);
+
+          dd.check_mtime (tp);
+
+          t.mtime (system_clock::now ());
+          return target_state::changed;
+        }
+      }
+
       // Ok, so we are updating. Finish building the command line.
       //
       string in, out, out1, out2, out3; // Storage.
@@ -3950,28 +4256,68 @@ namespace build2
       //
       // Note that we are not going to bother with oargs for this.
       //
+      // The extra threads are allocated from the scheduler so that the LTO
+      // link does not oversubscribe the machine (or end up serial). Their
+      // number can be limited with cc.lto_jobs. If, however, we are using a
+      // jobserver, then we let the linker that supports it take its jobs
+      // from there (allocating them from the scheduler would count them
+      // twice).
+      //
       string jobs_arg;
       scheduler::alloc_guard jobs_extra;
 
+      auto alloc_jobs = [&ctx, &t, this] ()
+      {
+        size_t m (0); // All available.
+
+        if (const uint64_t* n = cast_null<uint64_t> (t[c_lto_jobs]))
+        {
+          if (*n == 1)
+            return scheduler::alloc_guard ();
+
+          if (*n != 0)
+            m = static_cast<size_t> (*n - 1);
+        }
+
+        return scheduler::alloc_guard (*ctx.sched, m);
+      };
+
       if (!lt.static_library ())
       {
         switch (ctype)
         {
         case compiler_type::gcc:
           {
-            // Rewrite -flto=auto (available since GCC 10).
+            // Rewrite -flto=auto (available since GCC 10) and plain -flto
+            // (which since GCC 11 also means auto unless there is a
+            // jobserver).
             //
             // By default GCC 10 splits the optimization into 128 units.
             //
-            if (cmaj < 10)
+            // If we are using a jobserver, then rewrite them to
+            // -flto=jobserver instead so that GCC takes its jobs from the
+            // jobserver that is passed to it in MAKEFLAGS. Note, however,
+            // that lto-wrapper only understands the fifo jobserver form
+            // since GCC 13 (before that it falls back to serial LTO).
+            //
+            const jobserver* jsp (ctx.sched->used_jobserver ());
+            bool js (jsp != nullptr && (!jsp->fifo () || cmaj >= 13));
+
+            if (!js && cmaj < 10)
               break;
 
             auto i (find_option_prefix ("-flto", args.rbegin (), args.rend ()));
-            if (i != args.rend () && strcmp (*i, "-flto=auto") == 0)
+            if (i != args.rend () &&
+                (strcmp (*i, "-flto=auto") == 0 || strcmp (*i, "-flto") == 0))
             {
-              jobs_extra = scheduler::alloc_guard (*ctx.sched, 0);
-              jobs_arg = "-flto=" + to_string (1 + jobs_extra.n);
-              *i = jobs_arg.c_str ();
+              if (js)
+                *i = "-flto=jobserver";
+              else
+              {
+                jobs_extra = alloc_jobs ();
+                jobs_arg = "-flto=" + to_string (1 + jobs_extra.n);
+                *i = jobs_arg.c_str ();
+              }
             }
             break;
           }
@@ -3988,7 +4334,7 @@ namespace build2
                 strcmp (*i, "-flto=thin") == 0 &&
                 !find_option_prefix ("-flto-jobs=", args))
             {
-              jobs_extra = scheduler::alloc_guard (*ctx.sched, 0);
+              jobs_extra = alloc_jobs ();
               jobs_arg = "-flto-jobs=" + to_string (1 + jobs_extra.n);
               args.insert (i.base (), jobs_arg.c_str ()); // After -flto=thin.
             }
@@ -4328,6 +4674,9 @@ namespace build2
         }
       }
 
+      if (!ack.empty ())
+        ctx.acache->store (ack, paths {tp});
+
       if (!ctx.dry_run)
       {
         rm.cancel ();
@@ -124,6 +124,24 @@ namespace build2
           return i != end () ? &*i : nullptr;
         }
 
+        // Find existing entry corresponding to the specified entry (normally
+        // from another list).
+        //
+        appended_library*
+        find (const appended_library& al)
+        {
+          if (al.l2 == nullptr)
+            return find (*static_cast<const file*> (al.l1));
+
+          small_vector<reference_wrapper<const string>, 2> ns {
+            *static_cast<const string*> (al.l2)};
+
+          if (al.l1 != nullptr)
+            ns.push_back (*static_cast<const string*> (al.l1));
+
+          return find (ns);
+        }
+
         // Find existing or append new entry. If appending new, use the second
         // argument as the begin value.
         //
@@ -200,7 +218,38 @@ namespace build2
                         const scope&, action,
                         const file&, bool, lflags, linfo,
                         optional<bool>, bool = true, bool = true,
-                        library_cache* = nullptr) const;
+                        library_cache* = nullptr,
+                        vector<const file*>* = nullptr) const;
+
+      // The result of append_libraries() for a library starting from an
+      // empty list. It is memoized in the rule so that the library graph is
+      // traversed once per library rather than once per library per target
+      // that links it (see append_library_closure() for details).
+      //
+      struct library_closure
+      {
+        strings                  args;     // Library arguments.
+        vector<appended_library> libs;     // Appended libraries (into args).
+        vector<const file*>      inputs;   // Libraries to check if newer.
+        string                   checksum; // Hash of the libraries.
+
+        // Index of libs by library (see appended_library_key()).
+        //
+        map<pair<const void*, string>, size_t> index;
+      };
+
+      static pair<const void*, string>
+      appended_library_key (const appended_library&);
+
+      const library_closure&
+      find_library_closure (const scope&, action,
+                            const file&, bool, lflags, linfo,
+                            optional<bool>,
+                            library_cache*) const;
+
+      void
+      append_library_closure (appended_libraries&, strings&,
+                              const library_closure&) const;
 
       using rpathed_libraries = small_vector<const file*, 256>;
 
@@ -364,6 +413,30 @@ namespace build2
 
     private:
       const string rule_id;
+
+      struct library_closure_key
+      {
+        const file*    lib;
+        const scope*   base;
+        action         act;
+        lflags         flags;
+        linfo          li;
+        bool           la;
+        optional<bool> for_install;
+
+        bool
+        operator< (const library_closure_key& y) const
+        {
+          return std::tie (lib, base, act.inner_id, act.outer_id, flags,
+                           li.type, li.order, la, for_install) <
+                 std::tie (y.lib, y.base, y.act.inner_id, y.act.outer_id,
+                           y.flags, y.li.type, y.li.order, y.la,
+                           y.for_install);
+        }
+      };
+
+      mutable map<library_closure_key, library_closure> closures_;
+      mutable shared_mutex closures_mutex_;
     };
   }
 }
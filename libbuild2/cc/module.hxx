@@ -13,6 +13,7 @@
 #include <libbuild2/variable.hxx>
 
 #include <libbuild2/cc/common.hxx>
+#include <libbuild2/cc/library-index.hxx>
 
 #include <libbuild2/cc/compile-rule.hxx>
 #include <libbuild2/cc/link-rule.hxx>
@@ -143,7 +144,10 @@ namespace build2
             link_rule (move (d)),
             compile_rule (move (d), rs),
             install_rule (move (d), *this),
-            libux_install_rule (move (d), *this) {}
+            libux_install_rule (move (d), *this)
+      {
+        lib_index = &library_index::instance (rs.ctx);
+      }
 
       void
       init (scope&,
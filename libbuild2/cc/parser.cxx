@@ -3,6 +3,20 @@
 
 #include <libbuild2/cc/parser.hxx>
 
+#include <cstring>   // memcmp()
+#include <istream>
+
+#include <libbutl/bufstreambuf.hxx>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define LIBBUILD2_CC_PRESCAN_SSE2
+#  ifdef _MSC_VER
+#    include <intrin.h> // _BitScanForward()
+#  endif
+#endif
+
 #include <libbuild2/cc/lexer.hxx>
 
 using namespace std;
@@ -14,10 +28,185 @@ namespace build2
   {
     using type = token_type;
 
+    // Pre-scanning.
+    //
+    // The module-related declarations that we are interested in all start
+    // with one of the module, import, or export identifiers. So instead of
+    // tokenizing the entire (normally multi-megabyte) translation unit we
+    // first look for the last occurrence of any of these identifiers and
+    // only tokenize the source up to that point. Note that the result must
+    // be conservative: it's ok to consider something that is not a token
+    // (for example, inside a comment or a string literal) a candidate but
+    // not the other way around. In particular, if the source contains line
+    // continuations (which could split a keyword), then we give up and
+    // tokenize the whole thing.
+    //
+    static const size_t keyword_size (6);
+
+    static inline bool
+    identifier_char (char c)
+    {
+      return (c >= 'a' && c <= 'z') ||
+             (c >= 'A' && c <= 'Z') ||
+             (c >= '0' && c <= '9') ||
+             c == '_';
+    }
+
+    // Examine the potential candidate at position i. Return true if we
+    // should give up pre-scanning. Otherwise, update the end of the last
+    // candidate, if necessary.
+    //
+    static inline bool
+    prescan_candidate (const char* s, size_t n, size_t i, size_t& r)
+    {
+      if (s[i] == '\\')
+        return i + 1 != n && (s[i + 1] == '\n' || s[i + 1] == '\r');
+
+      if (n - i < keyword_size)
+        return false;
+
+      const char* k;
+      switch (s[i])
+      {
+      case 'm': k = "module"; break;
+      case 'i': k = "import"; break;
+      case 'e': k = "export"; break;
+      default:  return false;
+      }
+
+      if (memcmp (s + i, k, keyword_size) == 0                 &&
+          (i == 0 || !identifier_char (s[i - 1]))              &&
+          (n - i == keyword_size || !identifier_char (s[i + keyword_size])))
+        r = i + keyword_size;
+
+      return false;
+    }
+
+    // Return the position after the last candidate, 0 if there are none, or
+    // the source size if we should tokenize the whole thing.
+    //
+    static size_t
+    prescan (const char* s, size_t n)
+    {
+      size_t r (0);
+      size_t i (0);
+
+#ifdef LIBBUILD2_CC_PRESCAN_SSE2
+      // Compare a 16-byte block with the first character of each keyword
+      // and a block shifted by 5 with their last characters (module, import,
+      // export) which filters out most of the false positives before we
+      // examine each candidate. Also look for the backslash of potential
+      // line continuations.
+      //
+      const __m128i vm (_mm_set1_epi8 ('m'));
+      const __m128i vi (_mm_set1_epi8 ('i'));
+      const __m128i ve (_mm_set1_epi8 ('e'));
+      const __m128i vt (_mm_set1_epi8 ('t'));
+      const __m128i vb (_mm_set1_epi8 ('\\'));
+
+      for (; n - i >= 16 + keyword_size - 1; i += 16)
+      {
+        __m128i f (
+          _mm_loadu_si128 (reinterpret_cast<const __m128i*> (s + i)));
+        __m128i l (
+          _mm_loadu_si128 (
+            reinterpret_cast<const __m128i*> (s + i + keyword_size - 1)));
+
+        __m128i lt (_mm_cmpeq_epi8 (l, vt));
+
+        __m128i c (
+          _mm_or_si128 (
+            _mm_or_si128 (
+              _mm_and_si128 (_mm_cmpeq_epi8 (f, vm), _mm_cmpeq_epi8 (l, ve)),
+              _mm_and_si128 (_mm_or_si128 (_mm_cmpeq_epi8 (f, vi),
+                                           _mm_cmpeq_epi8 (f, ve)),
+                             lt)),
+            _mm_cmpeq_epi8 (f, vb)));
+
+        for (unsigned int b (
+               static_cast<unsigned int> (_mm_movemask_epi8 (c)));
+             b != 0;
+             b &= b - 1)
+        {
+#ifdef _MSC_VER
+          unsigned long j;
+          _BitScanForward (&j, b);
+#else
+          unsigned int j (static_cast<unsigned int> (__builtin_ctz (b)));
+#endif
+          if (prescan_candidate (s, n, i + j, r))
+            return n;
+        }
+      }
+#endif
+
+      for (; i != n; ++i)
+      {
+        if (prescan_candidate (s, n, i, r))
+          return n;
+      }
+
+      return r;
+    }
+
+    // Input stream buffer over the in-memory source.
+    //
+    // Note that we derive from bufstreambuf (rather than streambuf) so that
+    // char_scanner scans the buffer directly, the same as for fdstreambuf
+    // (the lexer relies on this to track token positions). The entire
+    // source is the get area and there is nothing to underflow.
+    //
+    namespace
+    {
+      class source_buf: public bufstreambuf
+      {
+      public:
+        source_buf (const char* b, size_t n)
+            : bufstreambuf (n)
+        {
+          char* p (const_cast<char*> (b)); // Read-only.
+          setg (p, p, p + n);
+        }
+      };
+    }
+
     void parser::
-    parse (ifdstream& is, const path_name& in, unit& u)
+    parse (ifdstream& is, const path_name& in, unit& u, bool cs)
     {
+      if (cs)
+      {
+        lexer l (is, in);
+        parse (l, u, nullopt);
+        checksum = l.checksum ();
+        return;
+      }
+
+      string s (is.read_text ());
+      parse (s.data (), s.size (), in, u, false);
+    }
+
+    void parser::
+    parse (const char* s, size_t n, const path_name& in, unit& u, bool cs)
+    {
+      checksum.clear ();
+
+      size_t p (cs ? n : prescan (s, n));
+      if (p == 0)
+        return; // Nothing to tokenize.
+
+      source_buf b (s, n);
+      istream is (&b);
+
       lexer l (is, in);
+      parse (l, u, p != n ? optional<uint64_t> (p) : nullopt);
+
+      if (cs)
+        checksum = l.checksum ();
+    }
+
+    void parser::
+    parse (lexer& l, unit& u, optional<uint64_t> stop)
+    {
       l_ = &l;
       u_ = &u;
 
@@ -62,6 +251,12 @@ namespace build2
           }
         case type::identifier:
           {
+            // If we are past the last pre-scanned candidate, then nothing
+            // else can be recognized.
+            //
+            if (stop && t.position >= *stop)
+              break;
+
             // Constructs we need to recognize:
             //
             //           module                                              ;
@@ -150,14 +345,15 @@ namespace build2
       //
       // @@ We now do that for missing include, so could do here as well.
       //
-      if (bb != 0)
+      // Note that if we've stopped early, then we cannot say anything about
+      // the balance.
+      //
+      if (bb != 0 && (bb < 0 || t.type == type::eos))
         warn (t) << (bb > 0 ? "missing '}'" : "extraneous '}'");
 
       if (module_marker_ && u.module_info.name.empty ())
         fail (*module_marker_) << "module declaration expected after "
                                << "global module fragment";
-
-      checksum = l.checksum ();
     }
 
     void parser::
@@ -17,6 +17,12 @@ namespace build2
   {
     // Extract translation unit information from a preprocessed C/C++ source.
     //
+    // If the checksum is not requested, then the source is first pre-scanned
+    // for the module-related keywords and the lexer is only used until the
+    // last potential module or import declaration (see prescan() for
+    // details). In this mode no checksum is calculated and the braces
+    // balance is only verified if the entire source had to be tokenized.
+    //
     struct token;
     class lexer;
 
@@ -24,17 +30,27 @@ namespace build2
     {
     public:
       unit
-      parse (ifdstream& is, const path_name& n)
+      parse (ifdstream& is, const path_name& n, bool checksum = true)
       {
         unit r;
-        parse (is, n, r);
+        parse (is, n, r, checksum);
         return r;
       }
 
       void
-      parse (ifdstream&, const path_name&, unit&);
+      parse (ifdstream&, const path_name&, unit&, bool checksum = true);
+
+      // As above but parse the source in memory (for example, a memory-
+      // mapped file). The source should remain unchanged during the call.
+      //
+      void
+      parse (const char*, size_t,
+             const path_name&, unit&, bool checksum = true);
 
     private:
+      void
+      parse (lexer&, unit&, optional<uint64_t> stop);
+
       void
       parse_module (token&, bool, location_value);
 
@@ -51,7 +67,7 @@ namespace build2
       parse_header_name (token&);
 
     public:
-      string checksum; // Translation unit checksum.
+      string checksum; // Translation unit checksum (empty if not requested).
 
     private:
       lexer* l_;
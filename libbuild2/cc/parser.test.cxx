@@ -1,10 +1,13 @@
 // file      : libbuild2/cc/parser.test.cxx -*- C++ -*-
 // license   : MIT; see accompanying LICENSE file
 
+#include <chrono>
+#include <cstring>  // strcmp()
 #include <iostream>
 
 #include <libbuild2/types.hxx>
 #include <libbuild2/utility.hxx>
+#include <libbuild2/filesystem.hxx>
 
 #include <libbuild2/cc/parser.hxx>
 
@@ -18,21 +21,47 @@ namespace build2
 {
   namespace cc
   {
-    // Usage: argv[0] [<file>]
+    static int
+    bench (int argc, char* argv[]);
+
+    // Usage: argv[0] [--prescan] [<file>]
+    //        argv[0] --bench <count> <file>...
+    //
+    // --prescan
+    //   Parse in the pre-scanning mode (without calculating the checksum).
+    //
+    // --bench
+    //   Parse each file the specified number of times reading it as a
+    //   stream, from a memory-mapped file, and from a memory-mapped file in
+    //   the pre-scanning mode and print the average time of each, for
+    //   example, on preprocessed (.ii) translation units.
     //
     int
     main (int argc, char* argv[])
     {
       try
       {
+        int i (1);
+        bool cs (true);
+
+        for (; i != argc; ++i)
+        {
+          if (strcmp (argv[i], "--prescan") == 0)
+            cs = false;
+          else if (strcmp (argv[i], "--bench") == 0)
+            return bench (argc - i - 1, argv + i + 1);
+          else
+            break;
+        }
+
         path file;
 
         path_name in;
         ifdstream is;
 
-        if (argc > 1)
+        if (i != argc)
         {
-          file = path (argv[1]);
+          file = path (argv[i]);
 
           in = path_name (file);
           is.open (file);
@@ -44,7 +73,7 @@ namespace build2
         }
 
         parser p;
-        unit u (p.parse (is, in));
+        unit u (p.parse (is, in, cs));
 
         switch (u.type)
         {
@@ -71,6 +100,85 @@ namespace build2
 
       return 0;
     }
+
+    static int
+    bench (int argc, char* argv[])
+    {
+      using namespace std::chrono;
+
+      assert (argc > 1);
+
+      size_t n (static_cast<size_t> (stoul (argv[0])));
+      assert (n != 0);
+
+      try
+      {
+        for (int i (1); i != argc; ++i)
+        {
+          path f (argv[i]);
+          path_name in (f);
+
+          // Modes: stream, mapped, and mapped with pre-scanning.
+          //
+          const size_t mn (3);
+          unit r[mn];
+          steady_clock::duration d[mn];
+
+          for (size_t m (0); m != mn; ++m)
+          {
+            steady_clock::time_point s (steady_clock::now ());
+
+            for (size_t j (0); j != n; ++j)
+            {
+              parser p;
+
+              if (m == 0)
+              {
+                ifdstream is (f, fdstream_mode::binary);
+                r[m] = unit ();
+                p.parse (is, in, r[m]);
+              }
+              else
+              {
+                mapped_file mf (f);
+                r[m] = unit ();
+                p.parse (mf.data (), mf.size (), in, r[m], m == 1);
+              }
+            }
+
+            d[m] = (steady_clock::now () - s) / n;
+          }
+
+          // All the modes should produce the same result.
+          //
+          for (size_t m (1); m != mn; ++m)
+            assert (r[0].type == r[m].type &&
+                    r[0].module_info.name == r[m].module_info.name &&
+                    r[0].module_info.imports.size () ==
+                    r[m].module_info.imports.size ());
+
+          auto us = [] (steady_clock::duration d)
+          {
+            return duration_cast<microseconds> (d).count ();
+          };
+
+          cout << f << ": stream " << us (d[0]) << "us"
+                    << ", mapped " << us (d[1]) << "us"
+                    << ", prescan " << us (d[2]) << "us" << endl;
+        }
+      }
+      catch (const io_error& e)
+      {
+        cerr << "error: " << e << endl;
+        return 1;
+      }
+      catch (const failed&)
+      {
+        return 1;
+      }
+
+      return 0;
+    }
   }
 }
 
@@ -132,13 +132,13 @@ namespace build2
     // This is now somewhat addressed, see the eflags argument in
     // pkg_config_pkg_find().
     //
-    pkgconfig::
-    pkgconfig (path_type p,
-               const dir_paths& pc_dirs,
-               const dir_paths& sys_lib_dirs,
-               const dir_paths& sys_hdr_dirs)
-        : path (move (p))
+    void pkgconfig::
+    load (const dir_paths& pc_dirs,
+          const dir_paths& sys_lib_dirs,
+          const dir_paths& sys_hdr_dirs) const
     {
+      assert (client_ == nullptr); // Must not be loaded.
+
       auto add_dirs = [] (pkg_config_list_t& dir_list,
                           const dir_paths& dirs,
                           bool suppress_dups)
@@ -203,9 +203,9 @@ namespace build2
     }
 
     strings pkgconfig::
-    cflags (bool stat) const
+    extract_cflags (bool stat) const
     {
-      assert (client_ != nullptr); // Must not be empty.
+      assert (client_ != nullptr); // Must be loaded.
 
       pkg_config_client_set_flags (
         client_,
@@ -233,9 +233,9 @@ namespace build2
     }
 
     strings pkgconfig::
-    libs (bool stat) const
+    extract_libs (bool stat) const
     {
-      assert (client_ != nullptr); // Must not be empty.
+      assert (client_ != nullptr); // Must be loaded.
 
       pkg_config_client_set_flags (
         client_,
@@ -258,9 +258,9 @@ namespace build2
     }
 
     optional<string> pkgconfig::
-    variable (const char* name) const
+    extract_variable (const char* name) const
     {
-      assert (client_ != nullptr); // Must not be empty.
+      assert (client_ != nullptr); // Must be loaded.
 
       const char* r (pkg_config_tuple_find (client_, &pkg_->vars, name));
       return r != nullptr ? optional<string> (r) : nullopt;
@@ -201,13 +201,13 @@ namespace build2
     // side would be useless. Also, for some functions the NULL result has a
     // special semantics, for example "not found".
     //
-    pkgconfig::
-    pkgconfig (path_type p,
-               const dir_paths& pc_dirs,
-               const dir_paths& sys_lib_dirs,
-               const dir_paths& sys_hdr_dirs)
-        : path (move (p))
+    void pkgconfig::
+    load (const dir_paths& pc_dirs,
+          const dir_paths& sys_lib_dirs,
+          const dir_paths& sys_hdr_dirs) const
     {
+      assert (client_ == nullptr); // Must not be loaded.
+
       auto add_dirs = [] (pkgconf_list_t& dir_list,
                           const dir_paths& dirs,
                           bool suppress_dups,
@@ -278,9 +278,9 @@ namespace build2
     }
 
     strings pkgconfig::
-    cflags (bool stat) const
+    extract_cflags (bool stat) const
     {
-      assert (client_ != nullptr); // Must not be empty.
+      assert (client_ != nullptr); // Must be loaded.
 
       mlock l (pkgconf_mutex);
 
@@ -312,9 +312,9 @@ namespace build2
     }
 
     strings pkgconfig::
-    libs (bool stat) const
+    extract_libs (bool stat) const
     {
-      assert (client_ != nullptr); // Must not be empty.
+      assert (client_ != nullptr); // Must be loaded.
 
       mlock l (pkgconf_mutex);
 
@@ -341,9 +341,9 @@ namespace build2
     }
 
     optional<string> pkgconfig::
-    variable (const char* name) const
+    extract_variable (const char* name) const
     {
-      assert (client_ != nullptr); // Must not be empty.
+      assert (client_ != nullptr); // Must be loaded.
 
       mlock l (pkgconf_mutex);
       const char* r (pkgconf_tuple_find (client_, &pkg_->vars, name));
@@ -16,6 +16,7 @@
 #include <libbuild2/cc/types.hxx>
 #include <libbuild2/cc/target.hxx>  // pc
 #include <libbuild2/cc/utility.hxx>
+#include <libbuild2/cc/library-index.hxx>
 
 #include <libbuild2/cc/common.hxx>
 #include <libbuild2/cc/pkgconfig.hxx>
@@ -92,6 +93,134 @@ namespace build2
     //
 #ifndef BUILD2_BOOTSTRAP
 
+    // pkgconfig
+    //
+    // Cached package information (see pkgconfig for details).
+    //
+    struct pkgconfig::cache_entry
+    {
+      timestamp mtime; // .pc file modification time.
+
+      dir_paths pc_dirs;
+      dir_paths sys_lib_dirs;
+      dir_paths sys_hdr_dirs;
+
+      // Extracted information, [static_].
+      //
+      // Note that the entry can be shared between threads so access to these
+      // members should be protected by the mutex.
+      //
+      mutex mtx;
+      optional<strings> cflags[2];
+      optional<strings> libs[2];
+      map<string, optional<string>> vars;
+    };
+
+    pkgconfig::
+    pkgconfig (path_type p,
+               const dir_paths& pc_dirs,
+               const dir_paths& sys_lib_dirs,
+               const dir_paths& sys_hdr_dirs)
+        : path (move (p))
+    {
+      timestamp mt (mtime (path));
+
+      if (mt == timestamp_nonexistent)
+        fail << "package '" << path << "' not found";
+
+      // The key is the path and the search directories since all of them
+      // affect the result.
+      //
+      string k (path.string ());
+      for (const dir_paths* ds: {&pc_dirs, &sys_lib_dirs, &sys_hdr_dirs})
+      {
+        k += '\n';
+        for (const dir_path& d: *ds)
+        {
+          k += d.string ();
+          k += path_traits::path_separator;
+        }
+      }
+
+      static map<string, shared_ptr<cache_entry>> cache;
+      static mutex cache_mutex;
+
+      mlock l (cache_mutex);
+
+      shared_ptr<cache_entry>& e (cache[move (k)]);
+
+      if (e == nullptr || e->mtime != mt)
+      {
+        e = make_shared<cache_entry> ();
+        e->mtime = mt;
+        e->pc_dirs = pc_dirs;
+        e->sys_lib_dirs = sys_lib_dirs;
+        e->sys_hdr_dirs = sys_hdr_dirs;
+      }
+
+      cache_ = e;
+    }
+
+    strings pkgconfig::
+    cflags (bool s) const
+    {
+      assert (cache_ != nullptr); // Must not be empty.
+
+      cache_entry& e (*cache_);
+      mlock l (e.mtx);
+
+      optional<strings>& r (e.cflags[s ? 1 : 0]);
+      if (!r)
+      {
+        if (client_ == nullptr)
+          load (e.pc_dirs, e.sys_lib_dirs, e.sys_hdr_dirs);
+
+        r = extract_cflags (s);
+      }
+
+      return *r;
+    }
+
+    strings pkgconfig::
+    libs (bool s) const
+    {
+      assert (cache_ != nullptr); // Must not be empty.
+
+      cache_entry& e (*cache_);
+      mlock l (e.mtx);
+
+      optional<strings>& r (e.libs[s ? 1 : 0]);
+      if (!r)
+      {
+        if (client_ == nullptr)
+          load (e.pc_dirs, e.sys_lib_dirs, e.sys_hdr_dirs);
+
+        r = extract_libs (s);
+      }
+
+      return *r;
+    }
+
+    optional<string> pkgconfig::
+    variable (const char* n) const
+    {
+      assert (cache_ != nullptr); // Must not be empty.
+
+      cache_entry& e (*cache_);
+      mlock l (e.mtx);
+
+      auto i (e.vars.find (n));
+      if (i == e.vars.end ())
+      {
+        if (client_ == nullptr)
+          load (e.pc_dirs, e.sys_lib_dirs, e.sys_hdr_dirs);
+
+        i = e.vars.emplace (n, extract_variable (n)).first;
+      }
+
+      return i->second;
+    }
+
     // Try to find a .pc file in the pkgconfig/ subdirectory of libd, trying
     // several names derived from stem. If not found, return false. If found,
     // load poptions, loptions, libs, and modules, set the corresponding
@@ -124,7 +253,9 @@ namespace build2
       // .pc files of autotools-based packages installed by the user often
       // still end up there.
       //
-      if (exists (pd /= "pkgconfig") && f (move (pd)))
+      if (lib_index->find (d, "pkgconfig") &&
+          exists (pd /= "pkgconfig")       &&
+          f (move (pd)))
         return true;
 
       // Platform-specific locations.
@@ -170,8 +301,8 @@ namespace build2
       // search (which directory(ies)) as well as what to search for (which
       // names). Suffix is our ".shared" or ".static" extension.
       //
-      auto search_dir = [&proj, &stem] (const dir_path& dir,
-                                        const string& sfx) -> path
+      auto search_dir = [&proj, &stem, this] (const dir_path& dir,
+                                              const string& sfx) -> path
       {
         path f;
 
@@ -192,13 +323,17 @@ namespace build2
         // lower-case versions of the stem unless we are on a case-insensitive
         // filesystem.
         //
-        auto check = [&dir, & sfx, &f] (const string& n)
+        // Note that we first consult the library index (see
+        // library-index.hxx for details) since most of these names won't
+        // exist.
+        //
+        string n; // Reuse the buffer.
+        auto check = [&dir, &sfx, &f, &n, this] (const string& s)
         {
-          f = dir;
-          f /= n;
-          f += sfx;
-          f += ".pc";
-          return exists (f);
+          n = s;
+          n += sfx;
+          n += ".pc";
+          return lib_index->find (dir, n, f) && exists (f);
         };
 
         if (check ("lib" + stem) || check (stem))
@@ -33,6 +33,16 @@ namespace build2
     // - in the directory of the specified file
     // - in pc_dirs directories (in the specified order)
     //
+    // The extracted information (the transitively flattened cflags/libs as
+    // well as the variable values) is cached process-wide, keyed by the .pc
+    // file path and search directories and validated with the .pc file
+    // modification time. This way a .pc file that is used by several targets
+    // (for example, as a common file for both liba{} and libs{}, by several
+    // projects, or in several contexts) is only parsed once. The underlying
+    // package is loaded lazily, on the first query that is not satisfied
+    // from the cache. Note that the cache does not track modifications to the
+    // dependency (Requires) .pc files.
+    //
     // Issue diagnostics and throw failed on any errors.
     //
     class pkgconfig
@@ -45,8 +55,8 @@ namespace build2
     public:
       pkgconfig (path_type,
                  const dir_paths& pc_dirs,
-                 const dir_paths& sys_hdr_dirs,
-                 const dir_paths& sys_lib_dirs);
+                 const dir_paths& sys_lib_dirs,
+                 const dir_paths& sys_hdr_dirs);
 
       // Create an unloaded/empty object. Querying package information on such
       // an object is illegal.
@@ -75,28 +85,49 @@ namespace build2
       variable (const string& s) const {return variable (s.c_str ());}
 
     private:
+      struct cache_entry;
+      shared_ptr<cache_entry> cache_; // NULL if empty.
+
+      // The underlying pkg-config library interface (implemented in
+      // pkgconfig-lib*.cxx).
+      //
+      void
+      load (const dir_paths& pc_dirs,
+            const dir_paths& sys_lib_dirs,
+            const dir_paths& sys_hdr_dirs) const;
+
+      strings
+      extract_cflags (bool static_) const;
+
+      strings
+      extract_libs (bool static_) const;
+
+      optional<string>
+      extract_variable (const char*) const;
+
       void
       free ();
 
 #ifndef BUILD2_LIBPKGCONF
-      pkg_config_client_t* client_ = nullptr;
-      pkg_config_pkg_t* pkg_ = nullptr;
+      mutable pkg_config_client_t* client_ = nullptr;
+      mutable pkg_config_pkg_t* pkg_ = nullptr;
 #else
-      pkgconf_client_t* client_ = nullptr;
-      pkgconf_pkg_t* pkg_ = nullptr;
+      mutable pkgconf_client_t* client_ = nullptr;
+      mutable pkgconf_pkg_t* pkg_ = nullptr;
 #endif
     };
 
     inline pkgconfig::
     ~pkgconfig ()
     {
-      if (client_ != nullptr) // Not empty.
+      if (client_ != nullptr) // Loaded.
         free ();
     }
 
     inline pkgconfig::
     pkgconfig (pkgconfig&& p) noexcept
         : path (move (p.path)),
+          cache_ (move (p.cache_)),
           client_ (p.client_),
           pkg_ (p.pkg_)
     {
@@ -109,10 +140,11 @@ namespace build2
     {
       if (this != &p)
       {
-        if (client_ != nullptr) // Not empty.
+        if (client_ != nullptr) // Loaded.
           free ();
 
         path = move (p.path);
+        cache_ = move (p.cache_);
         client_ = p.client_;
         pkg_ = p.pkg_;
 
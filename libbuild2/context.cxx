@@ -11,7 +11,9 @@
 #include <libbuild2/target.hxx>
 #include <libbuild2/variable.hxx>
 #include <libbuild2/function.hxx>
+#include <libbuild2/timeline.hxx>
 #include <libbuild2/diagnostics.hxx>
+#include <libbuild2/memory-arena.hxx>
 
 #include <libbutl/ft/exception.hxx> // uncaught_exceptions
 
@@ -42,6 +44,11 @@ namespace build2
 
   struct context::data
   {
+    // Note: declared first to be destroyed last (see module_data()).
+    //
+    map<const void*, current_data_ptr> module_data;
+    mutex module_data_mutex;
+
     scope_map scopes;
     target_set targets;
     variable_pool var_pool;
@@ -53,6 +60,8 @@ namespace build2
     variable_override_cache global_override_cache;
     strings global_var_overrides;
 
+    match_rule_cache match_cache;
+
     data (context& c)
         : scopes (c),
           targets (c),
@@ -60,6 +69,18 @@ namespace build2
           var_patterns (&c /* shared */, &var_pool) {}
   };
 
+  void* context::
+  module_data (const void* k, current_data_ptr (*create) ())
+  {
+    mlock l (data_->module_data_mutex);
+
+    auto i (data_->module_data.find (k));
+    if (i == data_->module_data.end ())
+      i = data_->module_data.emplace (k, create ()).first;
+
+    return i->second.get ();
+  }
+
   void context::
   reserve (reserves res)
   {
@@ -320,6 +341,7 @@ namespace build2
         global_target_types (data_->global_target_types),
         global_override_cache (data_->global_override_cache),
         global_var_overrides (data_->global_var_overrides),
+        match_cache (data_->match_cache),
         modules_lock (ml),
         module_context (mc ? *mc : nullptr),
         module_context_storage (mc
@@ -733,6 +755,7 @@ namespace build2
         global_target_types (data_->global_target_types),
         global_override_cache (data_->global_override_cache),
         global_var_overrides (data_->global_var_overrides),
+        match_cache (data_->match_cache),
         modules_lock (nullptr),
         module_context (nullptr)
   {
@@ -751,6 +774,11 @@ namespace build2
   ~context ()
   {
     // Cannot be inline since context::data is undefined.
+
+    // Write the timeline events before the targets they refer to are gone.
+    //
+    if (build_timeline != nullptr)
+      build_timeline->flush ();
   }
 
   void context::
@@ -855,6 +883,11 @@ namespace build2
     // Clear accumulated targets with post hoc prerequisites.
     //
     current_posthoc_targets.clear ();
+
+    // Clear the rule match candidates cache (rules could have been added
+    // while loading buildfiles for this operation).
+    //
+    data_->match_cache.clear ();
   }
 
   bool run_phase_mutex::
@@ -882,6 +915,14 @@ namespace build2
       //
       if (u)
       {
+        // If we are switching from the serial load (which is performed
+        // without taking the phase lock), then freeze the public variable
+        // pool (see unlock() for details). Nobody else can be accessing it
+        // in the unlocked state.
+        //
+        if (ctx_.phase == run_phase::load && n != run_phase::load)
+          ctx_.var_pool.rw ().freeze ();
+
         ctx_.phase = n;
         r = !fail_;
       }
@@ -890,7 +931,10 @@ namespace build2
         ++contention; // Protected by m_.
 
         ctx_.sched->deactivate (false /* external */);
-        for (; ctx_.phase != n; v->wait (l)) ;
+        {
+          timeline_scope tls (timeline::category::phase, "phase switch");
+          for (; ctx_.phase != n; v->wait (l)) ;
+        }
         r = !fail_;
         l.unlock (); // Important: activate() can block.
         ctx_.sched->activate (false /* external */);
@@ -906,7 +950,10 @@ namespace build2
       if (!lm_.try_lock ())
       {
         ctx_.sched->deactivate (false /* external */);
-        lm_.lock ();
+        {
+          timeline_scope tls (timeline::category::phase, "load lock");
+          lm_.lock ();
+        }
         ctx_.sched->activate (false /* external */);
 
         ++contention_load; // Protected by lm_.
@@ -920,10 +967,15 @@ namespace build2
   void run_phase_mutex::
   unlock (run_phase o)
   {
-    // In case of load, release the exclusive access mutex.
+    // In case of load, release the exclusive access mutex. But before that
+    // freeze the public variable pool so that the lookups in the following
+    // phases use the snapshot (we still have exclusive access).
     //
     if (o == run_phase::load)
+    {
+      ctx_.var_pool.rw ().freeze ();
       lm_.unlock ();
+    }
 
     {
       mlock l (m_);
@@ -982,7 +1034,10 @@ namespace build2
     bool s (true); // True switch.
 
     if (o == run_phase::load)
+    {
+      ctx_.var_pool.rw ().freeze (); // See unlock().
       lm_.unlock ();
+    }
 
     {
       mlock l (m_);
@@ -1031,7 +1086,10 @@ namespace build2
         ++contention; // Protected by m_.
 
         ctx_.sched->deactivate (false /* external */);
-        for (; ctx_.phase != n; v->wait (l)) ;
+        {
+          timeline_scope tls (timeline::category::phase, "phase switch");
+          for (; ctx_.phase != n; v->wait (l)) ;
+        }
         r = !fail_;
         l.unlock (); // Important: activate() can block.
         ctx_.sched->activate (false /* external */);
@@ -1050,7 +1108,10 @@ namespace build2
         s = false;
 
         ctx_.sched->deactivate (false /* external */);
-        lm_.lock ();
+        {
+          timeline_scope tls (timeline::category::phase, "load lock");
+          lm_.lock ();
+        }
         ctx_.sched->activate (false /* external */);
 
         ++contention_load; // Protected by lm_.
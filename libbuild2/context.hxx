@@ -21,6 +21,11 @@
 namespace build2
 {
   class file_cache;
+  class target_durations;
+  class diag_reactor;
+  class worker_pool;
+  class action_cache;
+  class memory_arena;
   class module_libraries_lock;
 
   class LIBBUILD2_SYMEXPORT run_phase_mutex
@@ -98,11 +103,50 @@ namespace build2
   class global_mutexes
   {
   public:
+    // Mutex shard padded to the cache line size to avoid false sharing
+    // between adjacent shards. Also counts the number of contentious locks
+    // (see --stat).
+    //
+    struct alignas (64) shard
+    {
+      shared_mutex   mutex;
+      atomic<size_t> contention {0};
+
+      // Lock the (deferred) shared or unique lock, counting contention.
+      //
+      template <typename L>
+      void
+      lock (L& l)
+      {
+        if (!l.try_lock ())
+        {
+          contention.fetch_add (1, memory_order_relaxed);
+          l.lock ();
+        }
+      }
+    };
 
     // Variable cache mutex shard (see variable.hxx for details).
     //
-    size_t                     variable_cache_size;
-    unique_ptr<shared_mutex[]> variable_cache;
+    size_t               variable_cache_size;
+    aligned_array<shard> variable_cache;
+
+    shard&
+    variable_cache_shard (const void* p)
+    {
+      return variable_cache[hash<const void*> () (p) % variable_cache_size];
+    }
+
+    // Total number of contentious variable cache shard locks.
+    //
+    size_t
+    variable_cache_contention () const
+    {
+      size_t r (0);
+      for (size_t i (0); i != variable_cache_size; ++i)
+        r += variable_cache[i].contention.load (memory_order_relaxed);
+      return r;
+    }
 
     explicit
     global_mutexes (size_t vc)
@@ -116,7 +160,7 @@ namespace build2
     init (size_t vc)
     {
       variable_cache_size = vc;
-      variable_cache.reset (new shared_mutex[vc]);
+      variable_cache.reset (vc);
     }
   };
 
@@ -216,6 +260,15 @@ namespace build2
     run_phase phase = run_phase::load;
     size_t load_generation = 0;
 
+    // Target memory arena (see --target-arena and target::operator new()).
+    //
+    // If not NULL, then targets are allocated from this arena and their
+    // memory is released all at once when the context is destroyed. Note
+    // that it must be set after construction and, since the targets are
+    // destroyed with the data_ member, must come before it.
+    //
+    unique_ptr<memory_arena> arena;
+
   private:
     struct data;
     unique_ptr<data> data_;
@@ -274,6 +327,34 @@ namespace build2
     //
     bool no_diag_buffer;
 
+    // Child process diagnostics reactor (see the --diag-reactor option). If
+    // not NULL, then diag_buffer reads the buffered diagnostics through it
+    // instead of blocking the worker thread.
+    //
+    // Note that it must be set after construction and must remain valid for
+    // the lifetime of the context instance.
+    //
+    diag_reactor* reactor = nullptr;
+
+    // Local worker pool (see the --worker-pool option). If not NULL, then
+    // rules that support it (currently the cc compile rule) execute their
+    // command lines through it.
+    //
+    // Note that it must be set after construction and must remain valid for
+    // the lifetime of the context instance.
+    //
+    worker_pool* workers = nullptr;
+
+    // Action cache (see the --action-cache option). If not NULL, then rules
+    // that support it (currently the cc compile and link rules as well as
+    // ad hoc buildscript recipes) look up their results there before
+    // executing and store them after.
+    //
+    // Note that it must be set after construction and must remain valid for
+    // the lifetime of the context instance.
+    //
+    action_cache* acache = nullptr;
+
     // Keep going flag.
     //
     // Note that setting it to false is not of much help unless we are running
@@ -290,6 +371,16 @@ namespace build2
     const vector<name>* trace_match = nullptr;
     const vector<name>* trace_execute = nullptr;
 
+    // Target execution durations tracking (see the --critical-path and
+    // --stat options). If not NULL, then the execution time of each target
+    // is recorded and, if available, the predicted critical paths are used
+    // to order the execution of prerequisites.
+    //
+    // Note that it must be set after construction and must remain valid for
+    // the lifetime of the context instance.
+    //
+    target_durations* durations = nullptr;
+
     // A "tri-mutex" that keeps all the threads in one of the three phases.
     // When a thread wants to switch a phase, it has to wait for all the other
     // threads to do the same (or release their phase locks). The load phase
@@ -367,6 +458,21 @@ namespace build2
     current_data_ptr current_inner_odata  = {nullptr, null_current_data_deleter};
     current_data_ptr current_outer_odata  = {nullptr, null_current_data_deleter};
 
+    // Context-global auxiliary data storage for build system modules.
+    //
+    // Unlike the above, this data is not cleared between meta/operations and
+    // is normally used for caches that should be shared among all the
+    // projects in this context (for example, the cc module's library index).
+    // The entry is identified by the address of an object (normally a static
+    // variable in the module) and is created by calling the specified
+    // function on the first request. It is destroyed together with the
+    // context.
+    //
+    // Note: MT-safe but watch out for MT-safety in the data itself.
+    //
+    void*
+    module_data (const void* key, current_data_ptr (*create) ());
+
     // Current operation number (1-based) in the meta-operation batch.
     //
     size_t current_on;
@@ -447,6 +553,10 @@ namespace build2
     variable_override_cache& global_override_cache;
     const strings& global_var_overrides;
 
+    // Rule match candidates cache (see match_rule() for details).
+    //
+    match_rule_cache& match_cache;
+
     // Cached values (from global scope).
     //
     const target_triplet* build_host; // build.host
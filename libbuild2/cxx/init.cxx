@@ -686,6 +686,9 @@ namespace build2
         vp["cc.module_name"],
         vp["cc.importable"],
         vp["cc.reprocess"],
+        vp["cc.direct"],
+        vp["cc.header_unit_cache"],
+        vp["cc.lto_jobs"],
 
         // Ability to signal that source is already (partially) preprocessed.
         // Valid values are 'none' (not preprocessed), 'includes' (no #include
@@ -0,0 +1,213 @@
+// file      : libbuild2/diag-reactor.cxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#include <libbuild2/diag-reactor.hxx>
+
+#ifdef __linux__
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/epoll.h>
+#  include <sys/eventfd.h>
+#endif
+
+#include <cerrno>
+
+#include <libbuild2/scheduler.hxx>
+#include <libbuild2/diagnostics.hxx>
+
+using namespace std;
+using namespace butl;
+
+namespace build2
+{
+  // A read in progress. Lives on the stack of the waiting thread.
+  //
+  struct diag_reactor_entry
+  {
+    int           fd;
+    vector<char>& buf;
+    int           error;
+
+    build2::mutex              mutex;
+    build2::condition_variable condv;
+    bool                       done = false; // EOF or error.
+  };
+
+  diag_reactor::
+  diag_reactor ()
+  {
+#ifdef __linux__
+    epfd_ = epoll_create1 (EPOLL_CLOEXEC);
+    if (epfd_ == -1)
+      fail << "unable to create epoll instance: "
+           << system_error (errno, generic_category ());
+
+    evfd_ = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (evfd_ == -1)
+    {
+      int e (errno);
+      ::close (epfd_);
+      fail << "unable to create eventfd: "
+           << system_error (e, generic_category ());
+    }
+
+    epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr; // Stop.
+
+    if (epoll_ctl (epfd_, EPOLL_CTL_ADD, evfd_, &ev) == -1)
+    {
+      int e (errno);
+      ::close (evfd_);
+      ::close (epfd_);
+      fail << "unable to register eventfd: "
+           << system_error (e, generic_category ());
+    }
+
+    thread_ = thread (&diag_reactor::thread_main, this);
+#else
+    fail << "diagnostics reactor not supported on this platform";
+#endif
+  }
+
+  diag_reactor::
+  ~diag_reactor ()
+  {
+#ifdef __linux__
+    if (thread_.joinable ())
+    {
+      uint64_t v (1);
+      while (::write (evfd_, &v, sizeof (v)) == -1 && errno == EINTR) ;
+      thread_.join ();
+    }
+
+    ::close (evfd_);
+    ::close (epfd_);
+#endif
+  }
+
+  void diag_reactor::
+  read (scheduler& sched, int fd, vector<char>& buf)
+  {
+    assert (!sched.serial ());
+
+#ifdef __linux__
+    int fl (fcntl (fd, F_GETFL));
+    if (fl == -1 || fcntl (fd, F_SETFL, fl | O_NONBLOCK) == -1)
+      throw_generic_ios_failure (errno);
+
+    diag_reactor_entry e {fd, buf, 0, {}, {}, false};
+
+    epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.ptr = &e;
+
+    if (epoll_ctl (epfd_, EPOLL_CTL_ADD, fd, &ev) == -1)
+      throw_generic_ios_failure (errno);
+
+    // Wait for EOF as an external waiter: we are waiting for the child
+    // process (which can run for arbitrarily long) rather than for other
+    // threads so this should not count towards deadlock detection (see
+    // scheduler::deactivate() for details).
+    //
+    // Note that the I/O thread may already be done with the entry by the
+    // time we get here.
+    //
+    sched.deactivate (true /* external */);
+    {
+      mlock l (e.mutex);
+      while (!e.done)
+        e.condv.wait (l);
+    }
+    sched.activate (true /* external */);
+
+    if (e.error != 0)
+      throw_generic_ios_failure (e.error);
+#else
+    (void) fd; (void) buf;
+    assert (false);
+#endif
+  }
+
+  void diag_reactor::
+  thread_main ()
+  {
+#ifdef __linux__
+    const size_t chunk (8192);
+
+    epoll_event evs[64];
+    for (;;)
+    {
+      int n (epoll_wait (epfd_, evs, 64, -1 /* infinite */));
+
+      if (n == -1)
+      {
+        // Any other error would mean we are misusing the interface.
+        //
+        assert (errno == EINTR);
+        continue;
+      }
+
+      for (int i (0); i != n; ++i)
+      {
+        diag_reactor_entry* pe (
+          static_cast<diag_reactor_entry*> (evs[i].data.ptr));
+
+        if (pe == nullptr)
+          return; // Stop.
+
+        diag_reactor_entry& e (*pe);
+        vector<char>& buf (e.buf);
+
+        // Read until blocked or EOF. Note that we get here on EPOLLHUP and
+        // EPOLLERR as well, in which case read() will tell us what's up.
+        //
+        bool done (false);
+        for (;;)
+        {
+          size_t p (buf.size ());
+
+          // Allocate at least a chunk to reduce reallocations (similar to
+          // diag_buffer::read()).
+          //
+          if (p == 0)
+            buf.reserve (chunk);
+
+          buf.resize (p + chunk);
+          ssize_t r (::read (e.fd, buf.data () + p, chunk));
+          buf.resize (p + (r > 0 ? static_cast<size_t> (r) : 0));
+
+          if (r > 0)
+            continue;
+
+          if (r == -1)
+          {
+            if (errno == EINTR)
+              continue;
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+              break;
+
+            e.error = errno;
+          }
+
+          done = true;
+          break;
+        }
+
+        if (done)
+        {
+          epoll_ctl (epfd_, EPOLL_CTL_DEL, e.fd, nullptr);
+
+          // Note that once we release the lock, the waiting thread may
+          // return and destroy the entry.
+          //
+          mlock l (e.mutex);
+          e.done = true;
+          e.condv.notify_one ();
+        }
+      }
+    }
+#endif
+  }
+}
@@ -0,0 +1,62 @@
+// file      : libbuild2/diag-reactor.hxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#ifndef LIBBUILD2_DIAG_REACTOR_HXX
+#define LIBBUILD2_DIAG_REACTOR_HXX
+
+#include <libbuild2/types.hxx>
+#include <libbuild2/forward.hxx>
+#include <libbuild2/utility.hxx>
+
+#include <libbuild2/export.hxx>
+
+namespace build2
+{
+  // Child process diagnostics reactor (see the --diag-reactor option).
+  //
+  // Normally, after starting a child process, a worker thread blocks reading
+  // its stderr (see diag_buffer::read()) which means it occupies one of the
+  // active thread slots for the duration of the process. With the reactor,
+  // the reading is instead performed by a single I/O thread that waits on
+  // the file descriptors of all the running processes while the worker
+  // thread is deactivated in the scheduler (as an external waiter) until
+  // EOF. This allows the scheduler to start other work (including other
+  // processes) in the meantime.
+  //
+  // Currently only supported on Linux (epoll).
+  //
+  class LIBBUILD2_SYMEXPORT diag_reactor
+  {
+  public:
+    // Start the I/O thread. Fail if unable to do so.
+    //
+    diag_reactor ();
+
+    // Stop the I/O thread. There should be no reads in progress.
+    //
+    ~diag_reactor ();
+
+    // Read the file descriptor until EOF appending the data to the buffer
+    // while waiting in the scheduler. The file descriptor is switched to the
+    // non-blocking mode. Throw io_error on the read error.
+    //
+    // Note that the scheduler must not be serial.
+    //
+    void
+    read (scheduler&, int fd, vector<char>& buf);
+
+    diag_reactor (const diag_reactor&) = delete;
+    diag_reactor& operator= (const diag_reactor&) = delete;
+
+  private:
+    void
+    thread_main ();
+
+  private:
+    int epfd_ = -1; // epoll instance.
+    int evfd_ = -1; // Stop eventfd.
+    thread thread_;
+  };
+}
+
+#endif // LIBBUILD2_DIAG_REACTOR_HXX
@@ -12,6 +12,7 @@
 #include <libbuild2/action.hxx>
 #include <libbuild2/target.hxx>
 #include <libbuild2/context.hxx>
+#include <libbuild2/diag-reactor.hxx>
 
 using namespace std;
 using namespace butl;
@@ -731,8 +732,21 @@ namespace build2
           {
             fdstreambuf& sb (*static_cast<fdstreambuf*> (is.rdbuf ()));
 
-            while (is.peek () != istream::traits_type::eof ())
+            // If we have the reactor, let it do the reading while we wait in
+            // the scheduler (and thus don't occupy an active thread slot).
+            // Note that we need to first copy what's already in the stream
+            // buffer (see custom processing).
+            //
+            if (ctx_.reactor != nullptr && !serial)
+            {
               copy (sb);
+              ctx_.reactor->read (*ctx_.sched, sb.fd (), buf);
+            }
+            else
+            {
+              while (is.peek () != istream::traits_type::eof ())
+                copy (sb);
+            }
           }
 
           r = false;
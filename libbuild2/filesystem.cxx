@@ -3,6 +3,10 @@
 
 #include <libbuild2/filesystem.hxx>
 
+#ifndef _WIN32
+#  include <sys/mman.h> // mmap(), munmap(), madvise()
+#endif
+
 #include <libbuild2/context.hxx>
 #include <libbuild2/diagnostics.hxx>
 
@@ -357,6 +361,71 @@ namespace build2
     }
   }
 
+  mapped_file::
+  mapped_file (const path& f)
+  {
+    try
+    {
+      auto_fd fd (fdopen (f, fdopen_mode::in | fdopen_mode::binary));
+
+      uint64_t n (fdstat (fd.get ()).size);
+      size_ = static_cast<size_t> (n);
+
+      if (size_ == 0)
+      {
+        data_ = "";
+        return;
+      }
+
+#ifndef _WIN32
+      // Note that the mapping stays valid after the file descriptor is
+      // closed.
+      //
+      void* p (mmap (nullptr, size_, PROT_READ, MAP_PRIVATE, fd.get (), 0));
+
+      if (p != MAP_FAILED)
+      {
+#ifdef MADV_SEQUENTIAL
+        madvise (p, size_, MADV_SEQUENTIAL);
+#endif
+        data_ = static_cast<const char*> (p);
+        mapped_ = true;
+        return;
+      }
+#endif
+
+      // Fallback to reading the whole thing.
+      //
+      ifdstream is (move (fd), fdstream_mode::binary, ifdstream::badbit);
+
+      buf_.resize (size_);
+      is.read (&buf_[0], static_cast<streamsize> (size_));
+
+      // The file could have been truncated in the meantime.
+      //
+      buf_.resize (static_cast<size_t> (is.gcount ()));
+      data_ = buf_.data ();
+      size_ = buf_.size ();
+    }
+    catch (const io_error& e)
+    {
+      fail << "unable to read " << f << ": " << e;
+    }
+    catch (const system_error& e)
+    {
+      fail << "unable to read " << f << ": " << e;
+    }
+  }
+
+  mapped_file::
+  ~mapped_file ()
+  {
+#ifndef _WIN32
+    if (mapped_)
+      munmap (const_cast<char*> (data_), size_);
+#endif
+  }
+
   void
   normalize_external (path& f, const char* what)
   {
@@ -192,6 +192,36 @@ namespace build2
   LIBBUILD2_SYMEXPORT void
   path_perms (const path&, permissions);
 
+  // Read-only view of a file contents in memory.
+  //
+  // Where supported (POSIX), the file is mapped into memory. Otherwise, or
+  // if mapping fails, it is read into a buffer allocated once based on the
+  // file size. Fail if unable to open or read the file.
+  //
+  class LIBBUILD2_SYMEXPORT mapped_file
+  {
+  public:
+    explicit
+    mapped_file (const path&);
+
+    ~mapped_file ();
+
+    const char*
+    data () const {return data_;}
+
+    size_t
+    size () const {return size_;}
+
+    mapped_file (const mapped_file&) = delete;
+    mapped_file& operator= (const mapped_file&) = delete;
+
+  private:
+    const char* data_ = nullptr;
+    size_t      size_ = 0;
+    bool        mapped_ = false;
+    string      buf_; // Contents if not mapped.
+  };
+
   // Normalize an absolute path to an existing file that may reside outside of
   // any project and could involve funny filesystem business (e.g., relative
   // directory symlinks). For example, a C/C++ header path returned by a
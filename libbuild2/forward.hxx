@@ -72,6 +72,10 @@ namespace build2
   class adhoc_rule;
   class adhoc_rule_pattern;
 
+  // <libbuild2/rule-map.hxx>
+  //
+  class match_rule_cache;
+
   // <libbuild2/context.hxx>
   //
   class context;
@@ -16,7 +16,9 @@ namespace build2
 {
   namespace in
   {
-    static const rule rule_ ("in", "in");
+    static const rule rule_ ("in", "in",
+                             '$', true /* strict */, nullopt /* null */,
+                             true /* memoize */);
 
     bool
     base_init (scope& rs,
@@ -3,6 +3,7 @@
 
 #include <libbuild2/in/rule.hxx>
 
+#include <cstring> // memchr()
 #include <cstdlib> // strtoull()
 
 #include <libbuild2/depdb.hxx>
@@ -22,6 +23,98 @@ namespace build2
 {
   namespace in
   {
+    // Substitution memo.
+    //
+    // The same variable is often substituted multiple times in the same .in
+    // file (think project name or version in a multi-megabyte template) and
+    // each lookup may involve a (typed) value conversion via the string()
+    // function and, while saving depdb, a sha256 calculation. So, if the rule
+    // allows it (see the memoize constructor argument), we resolve each
+    // distinct name/flags combination only once per target update.
+    //
+    // Note that the strict mode, substitution map, and null substitution
+    // string are fixed for the duration of the update so they don't need to
+    // be part of the key.
+    //
+    struct rule::substitution_memo
+    {
+      struct value_type
+      {
+        optional<string> value;
+        string           hash;  // sha256 of value, empty if not yet known.
+      };
+
+      map<pair<string, optional<uint64_t>>, value_type> values;
+    };
+
+    // Resolve the substitution via the memo, if not NULL, or into the
+    // specified temporary otherwise.
+    //
+    static rule::substitution_memo::value_type&
+    resolve (const rule& r,
+             rule::substitution_memo* m,
+             rule::substitution_memo::value_type& tmp,
+             const location& l,
+             action a, const target& t,
+             const string& n,
+             optional<uint64_t> flags,
+             bool strict,
+             const rule::substitution_map* smap,
+             const optional<string>& null)
+    {
+      if (m == nullptr)
+      {
+        tmp.value = r.substitute (l, a, t, n, flags, strict, smap, null);
+        tmp.hash.clear ();
+        return tmp;
+      }
+
+      auto i (m->values.find (make_pair (n, flags)));
+      if (i == m->values.end ())
+        i = m->values.emplace (
+          make_pair (n, flags),
+          rule::substitution_memo::value_type {
+            r.substitute (l, a, t, n, flags, strict, smap, null),
+            string ()}).first;
+
+      return i->second;
+    }
+
+    // Read the entire file.
+    //
+    static string
+    read_file (const path& f)
+    {
+      try
+      {
+        ifdstream is (f, fdopen_mode::binary, ifdstream::badbit);
+        string r (is.read_text ());
+        is.close ();
+        return r;
+      }
+      catch (const io_error& e)
+      {
+        fail << "unable to read " << f << ": " << e << endf;
+      }
+    }
+
+    // Return true if the two files have the same content.
+    //
+    static bool
+    same_content (const path& x, const path& y)
+    {
+      ifdstream xs (x, fdopen_mode::binary);
+      ifdstream ys (y, fdopen_mode::binary);
+
+      // Compare sizes first to avoid reading anything in the common case
+      // of a modified output.
+      //
+      if (fdstat (xs.fd ()).size != fdstat (ys.fd ()).size)
+        return false;
+
+      return xs.read_text () == ys.read_text ();
+    }
+
     bool rule::
     match (action a, target& xt) const
     {
@@ -131,8 +224,17 @@ namespace build2
 
       // Determine if anything needs to be updated.
       //
+      // Note that we exclude the .in file from the timestamp comparison and
+      // instead track its content in depdb (see below). Note also that we
+      // only ever use the first .in file so any others are irrelevant.
+      //
       timestamp mt (t.load_mtime ());
-      auto pr (execute_prerequisites<in> (a, t, mt));
+      auto pr (execute_prerequisites<in> (
+                 a, t, mt,
+                 [] (const target& pt, size_t)
+                 {
+                   return !pt.is_a<in> ();
+                 }));
 
       bool update (!pr.first);
       target_state ts (update ? target_state::changed : *pr.first);
@@ -147,7 +249,7 @@ namespace build2
 
       // First should come the rule name/version.
       //
-      if (dd.expect (rule_id_ + " 1") != nullptr)
+      if (dd.expect (rule_id_ + " 2") != nullptr)
         l4 ([&]{trace << "rule mismatch forcing update of " << t;});
 
       // Then the substitution symbol.
@@ -171,6 +273,33 @@ namespace build2
       if (dd.expect (i.path ()) != nullptr)
         l4 ([&]{trace << "in file mismatch forcing update of " << t;});
 
+      // Then the .in file content checksum.
+      //
+      // We only calculate (and compare) it if the .in file is newer than the
+      // output (or we need to write it). This way, if the .in file was only
+      // touched (or its changes reverted), then we don't need to redo the
+      // substitution and can keep the output unchanged.
+      //
+      optional<string> is; // .in file content, if read.
+      {
+        string* l (dd.read ());
+
+        if (l == nullptr || update || i.newer (mt))
+        {
+          is = read_file (ip);
+          string cs (sha256 (*is).string ());
+
+          if (l == nullptr || *l != cs)
+          {
+            if (l != nullptr)
+              l4 ([&]{trace << "in file content mismatch forcing update of "
+                            << t;});
+
+            dd.write (cs);
+          }
+        }
+      }
+
       // Update if any mismatch or depdb is newer that the output.
       //
       if (dd.writing () || dd.mtime > mt)
@@ -200,6 +329,9 @@ namespace build2
       //
       size_t dd_skip (0); // Number of "good" variable lines.
 
+      substitution_memo memo;
+      substitution_memo* m (memoize_ ? &memo : nullptr);
+
       if (update)
       {
         // If we are still reading, mark the next line for overwriting.
@@ -252,18 +384,25 @@ namespace build2
                 // Note that we have to call substitute(), not lookup() since
                 // it can be overriden with custom substitution semantics.
                 //
-                optional<string> v (
-                  substitute (location (ip, ln),
-                              a, t,
-                              name, flags,
-                              strict, smap, null));
+                substitution_memo::value_type tmp;
+                substitution_memo::value_type& mv (
+                  resolve (*this, m, tmp,
+                           location (ip, ln),
+                           a, t,
+                           name, flags,
+                           strict, smap, null));
+
+                // Rule semantics change without version increment?
+                //
+                assert (mv.value);
 
-                assert (v); // Rule semantics change without version increment?
+                if (mv.hash.empty ())
+                  mv.hash = sha256 (*mv.value).string ();
 
                 if (p3 != string::npos)
                   p3 -= p2; // Hash length.
 
-                if (s->compare (p2, p3, sha256 (*v).string ()) == 0)
+                if (s->compare (p2, p3, mv.hash) == 0)
                 {
                   dd_skip++;
                   continue;
@@ -329,25 +468,38 @@ namespace build2
         print_diag (program_.c_str (), move (ik), t);
       }
 
-      // Read and process the file, one line at a time, while updating depdb.
+      // Read the file in one go and then process it one line at a time while
+      // updating depdb.
+      //
+      // If the output already exists, then we write the result into a
+      // temporary file and only replace the output if the result differs.
+      // This way we don't trigger the update of everything that depends on
+      // the output if, say, the .in file was only touched or a changed
+      // variable is not actually substituted in the result.
       //
+      bool cmp (mt != timestamp_nonexistent);
+      path tmp (cmp ? tp + ".tmp" : path ());
+      const path& op (cmp ? tmp : tp);
+
+      bool changed (true);
+
       const char* what;
       const path* whom;
       try
       {
-        // Open the streams in the binary mode to preserve the .in file line
-        // endings.
+        // Note that the .in file is read and the output is opened in the
+        // binary mode to preserve the .in file line endings.
         //
-        what = "open"; whom = &ip;
-        ifdstream ifs (ip, fdopen_mode::binary, ifdstream::badbit);
+        if (!is)
+          is = read_file (ip);
 
-        what = "open"; whom = &tp;
+        what = "open"; whom = &op;
 #ifdef _WIN32
         // We don't need to worry about permissions on Windows and trying to
         // remove the file immediately before creating it sometimes can cause
         // open to fail with permission denied.
         //
-        ofdstream ofs (tp, fdopen_mode::binary);
+        ofdstream ofs (op, fdopen_mode::binary);
 #else
         // See fdopen() for details (umask, etc).
         //
@@ -362,15 +514,15 @@ namespace build2
         // this fails then presumable writing to it will fail as well and we
         // will complain there.
         //
-        try_rmfile (tp, true /* ignore_error */);
+        try_rmfile (op, true /* ignore_error */);
 
         // Note: no binary flag is added since this is noop on POSIX.
         //
-        ofdstream ofs (fdopen (tp,
+        ofdstream ofs (fdopen (op,
                                fdopen_mode::out | fdopen_mode::create,
                                prm));
 #endif
-        auto_rmfile arm (tp);
+        auto_rmfile arm (op);
 
         // Note: this default will only be used if the file is empty (i.e.,
         // does not contain even a newline).
@@ -383,12 +535,18 @@ namespace build2
 #endif
         );
 
+        what = "write"; whom = &op;
+
         uint64_t ln (1);
-        for (string s;; ++ln)
+        string s; // Reuse the buffer between lines.
+        for (size_t p (0), n (is->size ()); p != n; ++ln)
         {
-          what = "read"; whom = &ip;
-          if (!getline (ifs, s))
-            break; // Could not read anything, not even newline.
+          const char* b (is->c_str () + p);
+          const char* e (static_cast<const char*> (memchr (b, '\n', n - p)));
+
+          size_t m (e != nullptr ? e - b : n - p);
+          s.assign (b, m);
+          p += e != nullptr ? m + 1 : m;
 
           // Remember the line ending type and, if it is CRLF, strip the
           // trailing '\r'.
@@ -397,7 +555,6 @@ namespace build2
           if (crlf)
             s.pop_back();
 
-          what = "write"; whom = &tp;
           if (ln != 1)
             ofs << nl;
 
@@ -408,16 +565,26 @@ namespace build2
 
           // Not tracking column for now (see also depdb above).
           //
-          process (location (ip, ln),
-                   a, t,
-                   dd, dd_skip,
-                   s, 0,
-                   nl, sym, strict, smap, null);
+          // Note that in the memoizing mode we bypass process() (see the
+          // rule constructor for details).
+          //
+          if (m != nullptr)
+            process_impl (location (ip, ln),
+                          a, t,
+                          dd, dd_skip,
+                          s, 0,
+                          nl, sym, strict, smap, null,
+                          m);
+          else
+            process (location (ip, ln),
+                     a, t,
+                     dd, dd_skip,
+                     s, 0,
+                     nl, sym, strict, smap, null);
 
           ofs << s;
         }
 
-        what = "write"; whom = &tp;
         if (ln == 1)
           perform_update_pre (a, t, ofs, nl);
         perform_update_post (a, t, ofs, nl);
@@ -427,21 +594,54 @@ namespace build2
         //
         dd.close ();
 
-        what = "close"; whom = &tp;
+        what = "close";
         ofs << nl; // Last write to make sure our mtime is older than dd.
         ofs.close ();
-        arm.cancel ();
 
-        what = "close"; whom = &ip;
-        ifs.close ();
+        if (cmp)
+        {
+          what = "compare"; whom = &tp;
+          changed = !same_content (tmp, tp);
+
+          if (changed)
+            mvfile (tmp, tp, verb_never);
+          else
+          {
+            // Restore the "database mtime is not after target mtime"
+            // invariant (see depdb for details) by backdating the database
+            // to the (unchanged) output.
+            //
+            // Note that the .in file being newer than the output does not
+            // cause the substitution to be redone on the next run since we
+            // track it by content (see above).
+            //
+            what = "touch"; whom = &dd.path;
+            file_mtime (dd.path, mt);
+          }
+        }
+
+        if (changed) // Otherwise the temporary is removed by arm.
+          arm.cancel ();
       }
       catch (const io_error& e)
       {
         fail << "unable to " << what << ' ' << *whom << ": " << e;
       }
+      catch (const system_error& e)
+      {
+        fail << "unable to " << what << ' ' << *whom << ": " << e;
+      }
 
       dd.check_mtime (tp);
 
+      if (!changed)
+      {
+        l4 ([&]{trace << "output unchanged, keeping " << tp;});
+
+        t.mtime (mt);
+        return target_state::unchanged;
+      }
+
       t.mtime (system_clock::now ());
       return target_state::changed;
     }
@@ -480,17 +680,35 @@ namespace build2
              bool strict,
              const substitution_map* smap,
              const optional<string>& null) const
+    {
+      process_impl (l,
+                    a, t,
+                    dd, dd_skip,
+                    s, b,
+                    nl, sym, strict, smap, null,
+                    nullptr /* memo */);
+    }
+
+    void rule::
+    process_impl (const location& l,
+                  action a, const target& t,
+                  depdb& dd, size_t& dd_skip,
+                  string& s, size_t b,
+                  const char* nl,
+                  char sym,
+                  bool strict,
+                  const substitution_map* smap,
+                  const optional<string>& null,
+                  substitution_memo* m) const
     {
       // Scan the line looking for substiutions in the $<name>$ form. In the
       // strict mode treat $$ as an escape sequence.
       //
-      for (size_t n, d; b != (n = s.size ()); b += d)
+      // Note that we use find() (which normally boils down to memchr()) to
+      // skip to the next symbol since most lines contain none.
+      //
+      for (size_t d; (b = s.find (sym, b)) != string::npos; b += d)
       {
-        d = 1;
-
-        if (s[b] != sym)
-          continue;
-
         // Note that in the lax mode these should still be substitutions:
         //
         // @project@@
@@ -499,18 +717,15 @@ namespace build2
         // Find the other end.
         //
         size_t e (b + 1);
-        for (; e != (n = s.size ()); ++e)
+        for (; (e = s.find (sym, e)) != string::npos; ++e)
         {
-          if (s[e] == sym)
-          {
-            if (strict && e + 1 != n && s[e + 1] == sym) // Escape.
-              s.erase (e, 1); // Keep one, erase the other.
-            else
-              break;
-          }
+          if (strict && e + 1 != s.size () && s[e + 1] == sym) // Escape.
+            s.erase (e, 1); // Keep one, erase the other.
+          else
+            break;
         }
 
-        if (e == n)
+        if (e == string::npos)
         {
           if (strict)
             fail (l) << "unterminated '" << sym << "'";
@@ -523,18 +738,21 @@ namespace build2
           if (strict)
             s.erase (b, 1); // Keep one, erase the other.
 
+          d = 1;
           continue;
         }
 
         // We have a (potential, in the lax mode) substition with b pointing
         // to the opening symbol and e -- to the closing.
         //
-        if (optional<string> val = substitute (l,
-                                               a, t,
-                                               dd, dd_skip,
-                                               string (s, b + 1, e - b -1),
-                                               nullopt /* flags */,
-                                               strict, smap, null))
+        if (optional<string> val = substitute_impl (
+              l,
+              a, t,
+              dd, dd_skip,
+              string (s, b + 1, e - b -1),
+              nullopt /* flags */,
+              strict, smap, null,
+              m))
         {
           replace_newlines (*val, nl);
 
@@ -558,7 +776,30 @@ namespace build2
                 const substitution_map* smap,
                 const optional<string>& null) const
     {
-      optional<string> val (substitute (l, a, t, n, flags, strict, smap, null));
+      return substitute_impl (l,
+                              a, t,
+                              dd, dd_skip,
+                              n, flags,
+                              strict, smap, null,
+                              nullptr /* memo */);
+    }
+
+    optional<string> rule::
+    substitute_impl (const location& l,
+                     action a, const target& t,
+                     depdb& dd, size_t& dd_skip,
+                     const string& n,
+                     optional<uint64_t> flags,
+                     bool strict,
+                     const substitution_map* smap,
+                     const optional<string>& null,
+                     substitution_memo* m) const
+    {
+      substitution_memo::value_type tmp;
+      substitution_memo::value_type* mv (
+        &resolve (*this, m, tmp, l, a, t, n, flags, strict, smap, null));
+
+      const optional<string>& val (mv->value);
 
       if (val)
       {
@@ -566,6 +807,9 @@ namespace build2
         //
         if (dd_skip == 0)
         {
+          if (mv->hash.empty ())
+            mv->hash = sha256 (*val).string ();
+
           // The line format is:
           //
           // <ln> <name> <hash>[/<flags>]
@@ -574,7 +818,7 @@ namespace build2
           s += ' ';
           s += n;
           s += ' ';
-          s += sha256 (*val).string ();
+          s += mv->hash;
           if (flags)
           {
             s += '/';
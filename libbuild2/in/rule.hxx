@@ -25,6 +25,12 @@ namespace build2
     // Note also that currently this rule ignores the dry-run mode (see
     // perform_update() for the rationale).
     //
+    // Note finally that if the result of the substitution is the same as the
+    // existing output, then the output is left unchanged (including its
+    // modification time) so that its dependents are not updated. To make
+    // this work, the .in file is tracked by its content checksum rather than
+    // modification time.
+    //
     class LIBBUILD2_IN_SYMEXPORT rule: public simple_rule
     {
     public:
@@ -32,16 +38,24 @@ namespace build2
       // program argument is the pseudo-program name to use in the command
       // line diagnostics.
       //
+      // If memoize is true, then each distinct variable name/flags
+      // combination is substituted (and its value hashed) only once per
+      // target update. A derived rule should only enable this if its
+      // substitute() and lookup() results only depend on the name and flags
+      // and it does not override process() (which is bypassed in this mode).
+      //
       rule (string rule_id,
             string program,
             char symbol = '$',
             bool strict = true,
-            optional<string> null = nullopt)
+            optional<string> null = nullopt,
+            bool memoize = false)
           : rule_id_ (move (rule_id)),
             program_ (move (program)),
             symbol_ (symbol),
             strict_ (strict),
-            null_ (move (null)) {}
+            null_ (move (null)),
+            memoize_ (memoize) {}
 
       virtual bool
       match (action, target&) const override;
@@ -153,12 +167,42 @@ namespace build2
         }
       }
 
+      // Implementation details.
+      //
+    public:
+      struct substitution_memo;
+
+    private:
+      optional<string>
+      substitute_impl (const location&,
+                       action, const target&,
+                       depdb&, size_t&,
+                       const string&,
+                       optional<uint64_t>,
+                       bool,
+                       const substitution_map*,
+                       const optional<string>&,
+                       substitution_memo*) const;
+
+      void
+      process_impl (const location&,
+                    action, const target&,
+                    depdb&, size_t&,
+                    string&, size_t,
+                    const char*,
+                    char,
+                    bool,
+                    const substitution_map*,
+                    const optional<string>&,
+                    substitution_memo*) const;
+
     protected:
       const string rule_id_;
       const string program_;
       char symbol_;
       bool strict_;
       optional<string> null_;
+      bool memoize_;
     };
   }
 }
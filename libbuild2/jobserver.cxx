@@ -0,0 +1,298 @@
+// file      : libbuild2/jobserver.cxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#include <libbuild2/jobserver.hxx>
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/stat.h> // mkfifo(), fstat()
+#endif
+
+#include <cerrno>
+
+#include <libbuild2/filesystem.hxx> // try_rmfile()
+#include <libbuild2/diagnostics.hxx>
+
+using namespace std;
+using namespace butl;
+
+namespace build2
+{
+  jobserver::
+  ~jobserver ()
+  {
+#ifndef _WIN32
+    // Return the tokens we are still holding (normally there should be
+    // none) and close the descriptors, ignoring errors.
+    //
+    while (!tokens_.empty ())
+      release ();
+
+    if (rfd_ != -1)
+      ::close (rfd_);
+
+    if (close_wfd_ && wfd_ != -1 && wfd_ != rfd_)
+      ::close (wfd_);
+
+    if (prfd_ != -1)
+      ::close (prfd_);
+
+    if (!fifo_.empty ())
+    try
+    {
+      try_rmfile (fifo_);
+    }
+    catch (const system_error&) {}
+#endif
+  }
+
+  bool jobserver::
+  connect ()
+  {
+    tracer trace ("jobserver::connect");
+
+    optional<string> mf (getenv ("MAKEFLAGS"));
+    if (!mf)
+      return false;
+
+    // MAKEFLAGS is a space-separated list of options (the first word may be
+    // a group of single-letter options without the leading dash). The last
+    // --jobserver-auth (or its pre-4.2 --jobserver-fds name) wins.
+    //
+    string auth;
+    for (size_t b (0), e (0); next_word (*mf, b, e); )
+    {
+      string w (*mf, b, e - b);
+
+      if (w.compare (0, 17, "--jobserver-auth=") == 0)
+        auth.assign (w, 17, string::npos);
+      else if (w.compare (0, 16, "--jobserver-fds=") == 0)
+        auth.assign (w, 16, string::npos);
+    }
+
+    if (auth.empty ())
+      return false;
+
+    if (!open (auth))
+    {
+      warn << "jobserver specified in MAKEFLAGS is unavailable" <<
+        info << "running without jobserver";
+      return false;
+    }
+
+    l5 ([&]{trace << "connected to " << auth;});
+    return true;
+  }
+
+#ifndef _WIN32
+  // Return true if the file descriptor refers to a pipe or fifo.
+  //
+  static bool
+  fifo_fd (int fd)
+  {
+    struct stat s;
+    return fstat (fd, &s) == 0 && S_ISFIFO (s.st_mode);
+  }
+#endif
+
+  bool jobserver::
+  open (const string& auth)
+  {
+#ifndef _WIN32
+    if (auth.compare (0, 5, "fifo:") == 0)
+    {
+      // Note that we open it for both reading and writing so that the reads
+      // don't get EOF if there are no writers.
+      //
+      int fd (::open (auth.c_str () + 5, O_RDWR | O_NONBLOCK | O_CLOEXEC));
+      if (fd == -1)
+        return false;
+
+      if (!fifo_fd (fd))
+      {
+        ::close (fd);
+        return false;
+      }
+
+      rfd_ = wfd_ = fd;
+      close_wfd_ = true;
+      fifo_auth_ = true;
+      return true;
+    }
+
+    // The pipe form: <read-fd>,<write-fd>.
+    //
+    size_t p (auth.find (','));
+    if (p == string::npos)
+      return false;
+
+    int r, w;
+    try
+    {
+      r = stoi (string (auth, 0, p));
+      w = stoi (string (auth, p + 1));
+    }
+    catch (const std::exception&)
+    {
+      return false;
+    }
+
+    // If the parent did not pass the descriptors to us (for example, the
+    // make recipe is not marked with '+' or MAKEFLAGS is stale), then they
+    // are either closed or, worse, refer to something else (which we
+    // definitely don't want to read from or write to). So make sure they
+    // are pipes.
+    //
+    if (r < 0 || w < 0 || !fifo_fd (r) || !fifo_fd (w))
+      return false;
+
+    // We cannot make the shared read end non-blocking since that would
+    // affect other processes. Instead, on Linux we reopen it via /proc which
+    // gives us our own open file description. Elsewhere we give up.
+    //
+#ifdef __linux__
+    string pp ("/proc/self/fd/" + to_string (r));
+    int fd (::open (pp.c_str (), O_RDONLY | O_NONBLOCK | O_CLOEXEC));
+    if (fd == -1)
+      return false;
+
+    rfd_ = fd;
+    wfd_ = w;
+    close_wfd_ = false;
+    fifo_auth_ = false;
+    return true;
+#else
+    return false;
+#endif
+#else
+    (void) auth;
+    return false;
+#endif
+  }
+
+  void jobserver::
+  create (size_t jobs)
+  {
+#ifndef _WIN32
+    tracer trace ("jobserver::create");
+
+    string auth;
+
+#ifdef __linux__
+    // Create the jobserver as an anonymous pipe which is inherited by the
+    // child processes (note: not close-on-exec). We prefer this form since
+    // it is understood by older programs (GCC's lto-wrapper before 13, make
+    // before 4.4) while the fifo form is not. We can use it on Linux since
+    // here we can get our own non-blocking read end (see open()).
+    //
+    {
+      int fds[2];
+      if (pipe (fds) == -1)
+        fail << "unable to create jobserver pipe: "
+             << system_error (errno, generic_category ());
+
+      auth = to_string (fds[0]) + ',' + to_string (fds[1]);
+
+      if (!open (auth))
+      {
+        int e (errno);
+        ::close (fds[0]);
+        ::close (fds[1]);
+        fail << "unable to open jobserver pipe: "
+             << system_error (e, generic_category ());
+      }
+
+      prfd_ = fds[0];
+      close_wfd_ = true;
+    }
+#else
+    // Elsewhere we cannot make our read end non-blocking without affecting
+    // the child processes so we use a fifo.
+    //
+    {
+      path f;
+      try
+      {
+        f = path::temp_path ("build2-jobserver");
+      }
+      catch (const system_error& e)
+      {
+        fail << "unable to obtain temporary file for jobserver: " << e;
+      }
+
+      if (mkfifo (f.string ().c_str (), 0600) == -1)
+        fail << "unable to create jobserver fifo " << f << ": "
+             << system_error (errno, generic_category ());
+
+      fifo_ = f;
+
+      auth = "fifo:" + f.string ();
+      if (!open (auth))
+        fail << "unable to open jobserver fifo " << f << ": "
+             << system_error (errno, generic_category ());
+    }
+#endif
+
+    // Our own (implicit) token is not in the pool.
+    //
+    for (size_t i (1); i < jobs; ++i)
+    {
+      if (::write (wfd_, "+", 1) != 1)
+        fail << "unable to write to jobserver " << auth << ": "
+             << system_error (errno, generic_category ());
+    }
+
+    // Export to the child processes.
+    //
+    string v ("-j" + to_string (jobs) + " --jobserver-auth=" + auth);
+
+    if (optional<string> mf = getenv ("MAKEFLAGS"))
+    {
+      if (!mf->empty ())
+        v = *mf + ' ' + v;
+    }
+
+    setenv ("MAKEFLAGS", v);
+
+    l5 ([&]{trace << "created " << auth << " for " << jobs << " jobs";});
+#else
+    (void) jobs;
+    fail << "jobserver not supported on Windows";
+#endif
+  }
+
+  bool jobserver::
+  acquire ()
+  {
+#ifndef _WIN32
+    char c;
+    ssize_t n;
+    while ((n = ::read (rfd_, &c, 1)) == -1 && errno == EINTR) ;
+
+    if (n != 1)
+      return false; // EAGAIN or, for a broken jobserver, EOF/error.
+
+    tokens_ += c;
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void jobserver::
+  release ()
+  {
+#ifndef _WIN32
+    assert (!tokens_.empty ());
+
+    char c (tokens_.back ());
+    tokens_.pop_back ();
+
+    // Note that if this fails, then there is nothing much we can do: the
+    // token is lost (but the jobserver is probably broken anyway).
+    //
+    while (::write (wfd_, &c, 1) == -1 && errno == EINTR) ;
+#endif
+  }
+}
@@ -0,0 +1,92 @@
+// file      : libbuild2/jobserver.hxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#ifndef LIBBUILD2_JOBSERVER_HXX
+#define LIBBUILD2_JOBSERVER_HXX
+
+#include <libbuild2/types.hxx>
+#include <libbuild2/utility.hxx>
+
+#include <libbuild2/export.hxx>
+
+namespace build2
+{
+  // GNU make jobserver (see the --jobserver option).
+  //
+  // As a client, we connect to the jobserver specified in the MAKEFLAGS
+  // environment variable (both the fifo and the pipe file descriptors forms
+  // are supported) and the scheduler acquires a token before activating a
+  // helper thread beyond the first (which uses our implicit token; see
+  // scheduler::helper() for details).
+  //
+  // As a server, we create a jobserver with the number of tokens
+  // corresponding to --jobs, export it to the child processes in MAKEFLAGS,
+  // and then connect to it ourselves so that the build system and the
+  // programs it runs (compilers that understand the jobserver, nested make
+  // invocations, etc) share the same limit. On Linux the jobserver is a
+  // pipe (the most widely understood form) and elsewhere -- a fifo.
+  //
+  // Note that the token acquisition is non-blocking and the instance is not
+  // thread-safe (it is used by the scheduler while holding its lock).
+  //
+  // Currently only supported on POSIX.
+  //
+  class LIBBUILD2_SYMEXPORT jobserver
+  {
+  public:
+    jobserver () = default;
+
+    // Return any acquired tokens and remove the fifo if we are the server.
+    //
+    ~jobserver ();
+
+    // Connect to the jobserver specified in MAKEFLAGS. Return false if there
+    // is none or if it is unusable (for example, the file descriptors were
+    // not passed to us), in which case diagnose the latter as a warning.
+    //
+    bool
+    connect ();
+
+    // Create the jobserver for the specified number of jobs, export it in
+    // MAKEFLAGS, and connect to it. Fail if unable to do so.
+    //
+    void
+    create (size_t jobs);
+
+    // Try to acquire a token without blocking returning false if none is
+    // available.
+    //
+    bool
+    acquire ();
+
+    // Return a previously acquired token.
+    //
+    void
+    release ();
+
+    // Return true if the jobserver is specified in MAKEFLAGS in the fifo
+    // form (--jobserver-auth=fifo:PATH), which is only understood by newer
+    // programs (make 4.4, GCC 13).
+    //
+    bool
+    fifo () const {return fifo_auth_;}
+
+    jobserver (const jobserver&) = delete;
+    jobserver& operator= (const jobserver&) = delete;
+
+  private:
+    bool
+    open (const string& auth);
+
+  private:
+    int rfd_ = -1;
+    int wfd_ = -1;
+    int prfd_ = -1;          // Server pipe read end (inherited by children).
+    bool close_wfd_ = false; // Write end is ours (not inherited).
+    bool fifo_auth_ = false; // Fifo form.
+    string tokens_;          // Acquired tokens (returned as read).
+    path fifo_;              // Server fifo, if any.
+  };
+}
+
+#endif // LIBBUILD2_JOBSERVER_HXX
@@ -0,0 +1,157 @@
+// file      : libbuild2/jobserver.test.cxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#include <libbuild2/types.hxx>
+#include <libbuild2/utility.hxx>
+
+#include <libbuild2/jobserver.hxx>
+#include <libbuild2/scheduler.hxx>
+#include <libbuild2/diagnostics.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+
+namespace build2
+{
+  static void
+  inc (atomic<size_t>& n)
+  {
+    n.fetch_add (1, memory_order_relaxed);
+  }
+
+  // Run n tasks on a scheduler that takes its tokens from the jobserver.
+  //
+  static void
+  run (jobserver& js, size_t n)
+  {
+    scheduler s (4, 1, 0, 0);
+    s.use_jobserver (js);
+    assert (s.used_jobserver () == &js);
+
+    atomic<size_t> r (0);
+    scheduler::atomic_count task_count (0);
+
+    for (size_t i (0); i != n; ++i)
+      s.async (task_count, inc, ref (r));
+
+    s.wait (task_count);
+    assert (task_count == 0 && r == n);
+
+    s.shutdown ();
+  }
+
+  int
+  main (int, char* argv[])
+  {
+    // Fake build system driver, default verbosity.
+    //
+    init_diag (1);
+    init (nullptr, argv[0], true);
+
+#ifndef _WIN32
+    // No jobserver in MAKEFLAGS.
+    //
+    {
+      butl::unsetenv ("MAKEFLAGS");
+
+      jobserver js;
+      assert (!js.connect ());
+
+      butl::setenv ("MAKEFLAGS", "-k -j2");
+      assert (!js.connect ());
+    }
+
+    // Create the jobserver for 3 jobs: our implicit token plus 2 in the
+    // pool. Connect to it the same way a child process would (via MAKEFLAGS)
+    // and make sure the tokens are shared.
+    //
+    {
+      butl::setenv ("MAKEFLAGS", "-k");
+
+      jobserver s;
+      s.create (3);
+
+      // On Linux we create a pipe and elsewhere -- a fifo.
+      //
+      optional<string> mf (getenv ("MAKEFLAGS"));
+      assert (mf &&
+              mf->compare (0, 7, "-k -j3 ") == 0 &&
+              mf->find (" --jobserver-auth=") != string::npos);
+
+      jobserver c;
+      assert (c.connect ());
+
+#ifdef __linux__
+      assert (mf->find (" --jobserver-auth=fifo:") == string::npos);
+      assert (!s.fifo () && !c.fifo ());
+#else
+      assert (mf->find (" --jobserver-auth=fifo:") != string::npos);
+      assert (s.fifo () && c.fifo ());
+#endif
+
+      assert (c.acquire ());
+      assert (s.acquire ());
+      assert (!c.acquire () && !s.acquire ());
+
+      c.release ();
+      assert (s.acquire ());
+      assert (!c.acquire ());
+
+      s.release ();
+      s.release ();
+
+      // The scheduler returns all the tokens it acquired.
+      //
+      run (c, 100);
+
+      assert (s.acquire () && s.acquire () && !s.acquire ());
+      s.release ();
+      s.release ();
+
+      // With the pool exhausted the scheduler must still make progress using
+      // the implicit token (the starved helpers poll for a token and go back
+      // to sleep).
+      //
+      assert (s.acquire () && s.acquire ());
+      run (c, 100);
+      assert (!c.acquire ());
+      s.release ();
+      s.release ();
+    }
+
+    // Unusable pipe descriptors (not passed to us by make).
+    //
+    {
+      butl::setenv ("MAKEFLAGS", "-j2 --jobserver-auth=1000,1001");
+
+      jobserver js;
+      assert (!js.connect ());
+    }
+
+    // Descriptors referring to something other than a pipe (stale
+    // MAKEFLAGS).
+    //
+    {
+      auto_fd fd (butl::fdopen (path (argv[0]), fdopen_mode::in));
+      string f (to_string (fd.get ()));
+
+      butl::setenv ("MAKEFLAGS", "-j2 --jobserver-auth=" + f + ',' + f);
+
+      jobserver js;
+      assert (!js.connect ());
+    }
+
+    butl::unsetenv ("MAKEFLAGS");
+#endif
+
+    return 0;
+  }
+}
+
+int
+main (int argc, char* argv[])
+{
+  return build2::main (argc, argv);
+}
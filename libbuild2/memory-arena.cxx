@@ -0,0 +1,65 @@
+// file      : libbuild2/memory-arena.cxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#include <libbuild2/memory-arena.hxx>
+
+#include <new> // operator new/delete
+
+using namespace std;
+
+namespace build2
+{
+  memory_arena::
+  memory_arena (size_t bs)
+      : block_size_ (bs)
+  {
+  }
+
+  memory_arena::
+  ~memory_arena ()
+  {
+    for (void* b: blocks_)
+      ::operator delete (b);
+  }
+
+  void* memory_arena::
+  allocate (size_t n, size_t a)
+  {
+    assert (a != 0 && (a & (a - 1)) == 0 && a <= alignof (max_align_t));
+
+    mlock l (mutex_);
+
+    // Note that the blocks are max_align_t-aligned by operator new.
+    //
+    uintptr_t p (reinterpret_cast<uintptr_t> (next_));
+    uintptr_t r ((p + a - 1) & ~static_cast<uintptr_t> (a - 1));
+
+    if (next_ == nullptr || r + n > reinterpret_cast<uintptr_t> (end_))
+    {
+      // Allocate a new block. If the object is large (compared to the block
+      // size), then give it a block of its own but keep using the current
+      // block since it may still have plenty of space left.
+      //
+      blocks_.reserve (blocks_.size () + 1); // Don't leak if this throws.
+
+      if (n > block_size_ / 4)
+      {
+        void* b (::operator new (n));
+        blocks_.push_back (b);
+        allocated_.fetch_add (n, memory_order_relaxed);
+        return b;
+      }
+
+      char* b (static_cast<char*> (::operator new (block_size_)));
+      blocks_.push_back (b);
+
+      next_ = b;
+      end_ = b + block_size_;
+      r = reinterpret_cast<uintptr_t> (b);
+    }
+
+    next_ = reinterpret_cast<char*> (r + n);
+    allocated_.fetch_add (n, memory_order_relaxed);
+    return reinterpret_cast<void*> (r);
+  }
+}
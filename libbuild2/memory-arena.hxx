@@ -0,0 +1,61 @@
+// file      : libbuild2/memory-arena.hxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#ifndef LIBBUILD2_MEMORY_ARENA_HXX
+#define LIBBUILD2_MEMORY_ARENA_HXX
+
+#include <cstddef> // max_align_t
+
+#include <libbuild2/types.hxx>
+#include <libbuild2/utility.hxx>
+
+#include <libbuild2/export.hxx>
+
+namespace build2
+{
+  // Monotonic (bump) memory arena (see the --target-arena option).
+  //
+  // Memory is carved out of large blocks and is never released individually
+  // but only all at once when the arena is destroyed. This makes allocation
+  // cheap and avoids the per-allocation overhead and fragmentation of the
+  // general-purpose allocator for the large number of long-lived objects
+  // (such as targets) that share the lifetime of the context. Note that
+  // destructors of the objects allocated from the arena must still be
+  // called.
+  //
+  // Allocation is thread-safe.
+  //
+  class LIBBUILD2_SYMEXPORT memory_arena
+  {
+  public:
+    explicit
+    memory_arena (size_t block_size = 1024 * 1024);
+
+    ~memory_arena ();
+
+    // The alignment must be a power of 2 not greater than max_align_t.
+    //
+    void*
+    allocate (size_t size, size_t align = alignof (std::max_align_t));
+
+    // Total number of bytes allocated from the arena (see --stat).
+    //
+    size_t
+    allocated () const {return allocated_.load (memory_order_relaxed);}
+
+    memory_arena (const memory_arena&) = delete;
+    memory_arena& operator= (const memory_arena&) = delete;
+
+  private:
+    size_t block_size_;
+
+    mutex mutex_;
+    vector<void*> blocks_;
+    char* next_ = nullptr; // Next free byte in the current block.
+    char* end_ = nullptr;  // End of the current block.
+
+    atomic<size_t> allocated_ {0};
+  };
+}
+
+#endif // LIBBUILD2_MEMORY_ARENA_HXX
@@ -17,6 +17,7 @@
 #include <libbuild2/variable.hxx>
 #include <libbuild2/operation.hxx>
 #include <libbuild2/diagnostics.hxx>
+#include <libbuild2/memory-arena.hxx>
 
 // Core modules bundled with libbuild2.
 //
@@ -100,6 +101,12 @@ namespace build2
     //
     context& mctx (*(ctx.module_context = ctx.module_context_storage->get ()));
     mctx.module_context = &mctx;
+    mctx.reactor = ctx.reactor;
+    mctx.workers = ctx.workers;
+    mctx.acache = ctx.acache;
+
+    if (ctx.arena != nullptr)
+      mctx.arena.reset (new memory_arena);
 
     // Setup the context to perform update. In a sense we have a long-running
     // perform meta-operation batch (indefinite, in fact, since we never call
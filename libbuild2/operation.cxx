@@ -17,6 +17,7 @@
 #include <libbuild2/variable.hxx>
 #include <libbuild2/algorithm.hxx>
 #include <libbuild2/diagnostics.hxx>
+#include <libbuild2/target-durations.hxx>
 
 #if 0
 #include <libbuild2/adhoc-rule-buildscript.hxx> // @@ For a hack below.
@@ -584,6 +585,17 @@ namespace build2
       //
       ctx.dry_run = ctx.dry_run_option;
 
+      // Calculate the predicted critical paths, if tracking target execution
+      // durations (see target_durations for details).
+      //
+      if (ctx.durations != nullptr)
+      {
+        ctx.durations->predict (ctx, a);
+
+        if (a.outer ())
+          ctx.durations->predict (ctx, a.inner_action ());
+      }
+
       // Setup progress reporting if requested.
       //
       string what; // Note: must outlive monitor_guard.
@@ -168,6 +168,107 @@ namespace build2
     operation_rule_map map_;
     unique_ptr<rule_map> next_;
   };
+
+  // Cache of rule match candidates (see match_rule() for details).
+  //
+  // For the same base scope, target type, action, and rule hint, the list of
+  // candidate rules (that is, the result of walking the scope chain and the
+  // above maps) is always the same. So instead of redoing this for every
+  // target we cache it, including the pre-resolved information on whether a
+  // candidate is an ad hoc rule and whether it was found via the operation
+  // wildcard (fallback). Each candidate also records the end of its
+  // ambiguity group (rules from the same name map that must be tried for
+  // ambiguity once one of them matches).
+  //
+  // Additionally, if all the rules whose match() had to be called to arrive
+  // at the decision are target-independent (see rule::match_independent()),
+  // then the decision itself is cached.
+  //
+  // Since rules are only registered during load, an entry is only valid for
+  // the load generation it was created in. The cache is also cleared at the
+  // beginning of each operation (see context::current_operation()).
+  //
+  // MT-safe.
+  //
+  struct match_rule_candidate
+  {
+    const name_rule_map::value_type* rule;
+
+    size_t group_end;   // Ambiguity group end (index in candidates).
+    bool   fallback;    // Found via operation wildcard.
+    bool   adhoc;       // Ad hoc rule.
+    bool   independent; // Target-independent match().
+  };
+
+  struct match_rule_candidates
+  {
+    size_t                       generation; // Load generation.
+    vector<match_rule_candidate> candidates;
+
+    // Index of the cached decision or candidates.size() if none.
+    //
+    mutable atomic<size_t> decision;
+  };
+
+  class match_rule_cache
+  {
+  public:
+    struct key
+    {
+      const scope*       base;
+      const target_type* type;
+      meta_operation_id  meta_operation;
+      operation_id       operation;
+      string             hint;
+      bool               retry;
+
+      bool
+      operator< (const key& y) const
+      {
+        if (base != y.base)       return base < y.base;
+        if (type != y.type)       return type < y.type;
+        if (retry != y.retry)     return retry < y.retry;
+        if (operation != y.operation)
+          return operation < y.operation;
+        if (meta_operation != y.meta_operation)
+          return meta_operation < y.meta_operation;
+        return hint < y.hint;
+      }
+    };
+
+    using value_type = shared_ptr<const match_rule_candidates>;
+
+    // Return NULL if not found or out of date.
+    //
+    value_type
+    find (const key& k, size_t generation) const
+    {
+      slock l (mutex_);
+
+      auto i (map_.find (k));
+      return i != map_.end () && i->second->generation == generation
+        ? i->second
+        : value_type ();
+    }
+
+    void
+    insert (key k, value_type v)
+    {
+      ulock l (mutex_);
+      map_[move (k)] = move (v);
+    }
+
+    void
+    clear ()
+    {
+      ulock l (mutex_);
+      map_.clear ();
+    }
+
+  private:
+    map<key, value_type> map_;
+    mutable shared_mutex mutex_;
+  };
 }
 
 #endif // LIBBUILD2_RULE_MAP_HXX
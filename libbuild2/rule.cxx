@@ -3,6 +3,8 @@
 
 #include <libbuild2/rule.hxx>
 
+#include <typeinfo>
+
 #include <libbuild2/scope.hxx>
 #include <libbuild2/target.hxx>
 #include <libbuild2/context.hxx>
@@ -30,6 +32,12 @@ namespace build2
     return nullptr;
   }
 
+  bool rule::
+  match_independent () const
+  {
+    return false;
+  }
+
   const rule_match*
   match_adhoc_recipe (action, target&, match_extra&); // algorithm.cxx
 
@@ -211,6 +219,12 @@ namespace build2
     return true;
   }
 
+  bool alias_rule::
+  match_independent () const
+  {
+    return typeid (*this) == typeid (alias_rule); // Not inherited (see rule).
+  }
+
   recipe alias_rule::
   apply (action a, target& t) const
   {
@@ -249,6 +263,12 @@ namespace build2
     return true;
   }
 
+  bool fsdir_rule::
+  match_independent () const
+  {
+    return typeid (*this) == typeid (fsdir_rule); // Not inherited (see rule).
+  }
+
   recipe fsdir_rule::
   apply (action a, target& t) const
   {
@@ -384,6 +404,12 @@ namespace build2
     return true;
   }
 
+  bool noop_rule::
+  match_independent () const
+  {
+    return typeid (*this) == typeid (noop_rule); // Not inherited (see rule).
+  }
+
   recipe noop_rule::
   apply (action, target&) const
   {
@@ -53,6 +53,24 @@ namespace build2
     rule (const rule&) = delete;
     rule& operator= (const rule&) = delete;
 
+    // Return true if this rule's match() result only depends on the action,
+    // target type, base scope, and rule hint (and not on the target itself).
+    // Such a rule is always expected to match or not match the same way for
+    // all targets with the same combination and the match decision for it
+    // may be cached and reused without calling match() (see match_rule()
+    // for details). Note that in this case match() should also not modify
+    // match_extra. The default implementation returns false.
+    //
+    // Note that this property should not be inherited since a derived rule
+    // may well override match() to examine the target. As a result, an
+    // implementation should return true only for its exact type, for
+    // example:
+    //
+    // return typeid (*this) == typeid (alias_rule);
+    //
+    virtual bool
+    match_independent () const;
+
     // Resolve a project-qualified target in a rule-specific manner.
     //
     // This is optional functionality that may be provided by some rules to
@@ -138,6 +156,9 @@ namespace build2
     virtual bool
     match (action, target&) const override;
 
+    virtual bool
+    match_independent () const override;
+
     virtual recipe
     apply (action, target&) const override;
 
@@ -154,6 +175,9 @@ namespace build2
     virtual bool
     match (action, target&) const override;
 
+    virtual bool
+    match_independent () const override;
+
     virtual recipe
     apply (action, target&) const override;
 
@@ -181,6 +205,9 @@ namespace build2
     virtual bool
     match (action, target&) const override;
 
+    virtual bool
+    match_independent () const override;
+
     virtual recipe
     apply (action, target&) const override;
 
@@ -21,8 +21,17 @@
 #  include <chrono>
 #endif
 
+#ifdef __linux__
+#  include <unistd.h>      // syscall()
+#  include <sys/syscall.h> // SYS_futex
+#  include <linux/futex.h>
+#endif
+
 #include <cerrno>
+#include <climits> // INT_MAX
 
+#include <libbuild2/timeline.hxx>
+#include <libbuild2/jobserver.hxx>
 #include <libbuild2/diagnostics.hxx>
 
 using namespace std;
@@ -213,6 +222,44 @@ namespace build2
     active_ -= n;
   }
 
+#ifdef __linux__
+  // Note that we rely on atomic<uint32_t> having the same representation as
+  // uint32_t, which is the case for all the implementations we care about.
+  //
+  static_assert (sizeof (atomic<uint32_t>) == sizeof (uint32_t),
+                 "unexpected atomic<uint32_t> representation");
+
+  static inline void
+  futex_wait (atomic<uint32_t>& w, uint32_t v)
+  {
+    // Return immediately if the value has changed (EAGAIN) and may return
+    // spuriously (EINTR). The caller re-examines the condition in any case.
+    //
+    syscall (SYS_futex,
+             reinterpret_cast<uint32_t*> (&w), FUTEX_WAIT_PRIVATE, v,
+             nullptr, nullptr, 0);
+  }
+
+  static inline void
+  futex_wake (atomic<uint32_t>& w)
+  {
+    syscall (SYS_futex,
+             reinterpret_cast<uint32_t*> (&w), FUTEX_WAKE_PRIVATE, INT_MAX,
+             nullptr, nullptr, 0);
+  }
+#endif
+
+  void scheduler::
+  wake (wait_slot& s)
+  {
+#ifdef __linux__
+    s.futex_seq.fetch_add (1, memory_order_release);
+    futex_wake (s.futex_seq);
+#else
+    (void) s;
+#endif
+  }
+
   size_t scheduler::
   suspend (size_t start_count, const atomic_count& task_count)
   {
@@ -220,18 +267,53 @@ namespace build2
       wait_queue_[
         hash<const atomic_count*> () (&task_count) % wait_queue_size_]);
 
+    timeline_scope tls (timeline::category::wait, "scheduler wait");
+
     // This thread is no longer active.
     //
     deactivate (false /* external */);
 
-    // Note that the task count is checked while holding the lock. We also
-    // have to notify while holding the lock (see resume()). The aim here
-    // is not to end up with a notification that happens between the check
-    // and the wait.
-    //
     size_t tc (0);
     bool collision;
+
+#ifdef __linux__
+    if (futex_)
+    {
+      // Here the waiters increment must be ordered before the task count
+      // check and the task count change before the waiters check in
+      // resume(). This way either we see the new task count or resume()
+      // sees us.
+      //
+      const atomic_count* ptc (
+        s.futex_task_count.exchange (&task_count, memory_order_relaxed));
+
+      collision = (s.futex_waiters.fetch_add (1, memory_order_seq_cst) != 0 &&
+                   ptc != &task_count);
+
+      for (;;)
+      {
+        // Load the sequence number before checking the task count so that
+        // we don't miss the wakeup that happens in between.
+        //
+        uint32_t q (s.futex_seq.load (memory_order_acquire));
+
+        if (s.futex_shutdown.load (memory_order_acquire) ||
+            (tc = task_count.load (memory_order_seq_cst)) <= start_count)
+          break;
+
+        futex_wait (s.futex_seq, q);
+      }
+
+      s.futex_waiters.fetch_sub (1, memory_order_release);
+    }
+    else
+#endif
     {
+      // Note that the task count is checked while holding the lock. We also
+      // have to notify while holding the lock (see resume()). The aim here
+      // is not to end up with a notification that happens between the check
+      // and the wait.
+      //
       lock l (s.mutex);
 
       // We have a collision if there is already a waiter for a different
@@ -273,6 +355,18 @@ namespace build2
     wait_slot& s (
       wait_queue_[hash<const atomic_count*> () (&tc) % wait_queue_size_]);
 
+    if (futex_)
+    {
+      // See suspend() for details on the ordering.
+      //
+      atomic_thread_fence (memory_order_seq_cst);
+
+      if (s.futex_waiters.load (memory_order_relaxed) != 0)
+        wake (s);
+
+      return;
+    }
+
     // See suspend() for why we must hold the lock.
     //
     lock l (s.mutex);
@@ -379,6 +473,8 @@ namespace build2
     lock l (mutex_);
 
     max_stack_ = max_stack;
+    jobserver_ = nullptr;
+    futex_ = false;
 
     // Use 8x max_active on 32-bit and 32x max_active on 64-bit. Unless we
     // were asked to run serially.
@@ -414,7 +510,7 @@ namespace build2
     queued_task_count_.store (0, memory_order_relaxed);
 
     if ((wait_queue_size_ = max_threads == 1 ? 0 : shard_size ()) != 0)
-      wait_queue_.reset (new wait_slot[wait_queue_size_]);
+      wait_queue_.reset (wait_queue_size_);
 
     // Reset other state.
     //
@@ -428,7 +524,10 @@ namespace build2
     progress_.store (0, memory_order_relaxed);
 
     for (size_t i (0); i != wait_queue_size_; ++i)
+    {
       wait_queue_[i].shutdown = false;
+      wait_queue_[i].futex_shutdown.store (false, memory_order_relaxed);
+    }
 
     shutdown_ = false;
 
@@ -499,6 +598,7 @@ namespace build2
         wait_slot& ws (wait_queue_[i]);
         lock l (ws.mutex);
         ws.shutdown = true;
+        ws.futex_shutdown.store (true, memory_order_release);
       }
 
       for (task_queue& tq: task_queues_)
@@ -527,7 +627,12 @@ namespace build2
 
         if (w)
           for (size_t i (0); i != wait_queue_size_; ++i)
-            wait_queue_[i].condv.notify_all ();
+          {
+            if (futex_)
+              wake (wait_queue_[i]);
+            else
+              wait_queue_[i].condv.notify_all ();
+          }
 
         this_thread::yield ();
         l.lock ();
@@ -924,12 +1029,35 @@ namespace build2
     lock l (s.mutex_);
     s.starting_--;
 
+    bool starved (false); // Unable to acquire jobserver token.
+
     while (!s.shutdown_)
     {
       // If there is a spare active thread, become active and go looking for
       // some work.
       //
-      if (s.active_ < s.max_active_)
+      // If we have a jobserver, then we also need a token unless there are
+      // no other active threads, in which case we use our implicit token
+      // (this also makes sure we cannot stall when there are queued tasks
+      // but nobody to work them). Note that waiting threads that become
+      // active again (see activate()) keep using their tokens or the implicit
+      // one, so we may end up slightly over the limit but only temporarily.
+      //
+      // If we were unable to acquire a token, then we go idle but only for a
+      // short while since the token may be returned by another process.
+      //
+      bool token (false);
+
+      if (s.active_ < s.max_active_ &&
+          s.jobserver_ != nullptr   &&
+          s.active_ != 0            &&
+          s.queued_task_count_.load (memory_order_consume) != 0)
+      {
+        token = s.jobserver_->acquire ();
+        starved = !token;
+      }
+
+      if (s.active_ < s.max_active_ && !starved)
       {
         s.active_++;
 
@@ -963,6 +1091,9 @@ namespace build2
 
         s.active_--;
 
+        if (token)
+          s.jobserver_->release ();
+
         // While executing the tasks a thread might have become ready
         // (equivalent logic to deactivate()).
         //
@@ -975,7 +1106,15 @@ namespace build2
       // Become idle and wait for a notification.
       //
       s.idle_++;
-      s.idle_condv_.wait (l);
+
+      if (starved)
+      {
+        s.idle_condv_.wait_for (l, chrono::milliseconds (20));
+        starved = false;
+      }
+      else
+        s.idle_condv_.wait (l);
+
       s.idle_--;
     }
 
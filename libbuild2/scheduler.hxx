@@ -17,6 +17,8 @@
 
 namespace build2
 {
+  class jobserver;
+
   // Scheduler of tasks and threads. Works best for "substantial" tasks (e.g.,
   // running a process), where in comparison thread synchronization overhead
   // is negligible.
@@ -335,6 +337,38 @@ namespace build2
              optional<size_t> max_stack = nullopt,
              size_t orig_max_active = 0);
 
+    // Acquire a token from the specified jobserver before activating a
+    // helper thread unless there are no other active threads (see jobserver
+    // for details). Should be called after startup() and before scheduling
+    // any tasks. The jobserver must outlive the session.
+    //
+    void
+    use_jobserver (jobserver& js) {jobserver_ = &js;}
+
+    // Return the jobserver the scheduler is using or NULL if none.
+    //
+    // Note that since the jobserver is set before scheduling any tasks, this
+    // function can be called without holding the lock by task threads.
+    //
+    const jobserver*
+    used_jobserver () const {return jobserver_;}
+
+    // Use futex-based waiting for task counts instead of the mutex and
+    // condition variable-based wait slots (see the wait queue below for
+    // details). Return false if not supported on this platform (currently
+    // only Linux is). Should be called after startup() and before scheduling
+    // any tasks.
+    //
+    bool
+    use_futex ()
+    {
+#ifdef __linux__
+      return futex_ = true;
+#else
+      return false;
+#endif
+    }
+
     // Return true if the scheduler was started up.
     //
     // Note: can only be called from threads that have observed creation,
@@ -586,6 +620,9 @@ namespace build2
 
     optional<size_t> max_stack_;
 
+    jobserver* jobserver_ = nullptr; // Protected by mutex_.
+    bool       futex_ = false;       // Futex-based waiting (see use_futex()).
+
     // The constraints that we must maintain:
     //
     //                  active <= max_active
@@ -661,17 +698,33 @@ namespace build2
     // The pointer to the task count is used to identify the already waiting
     // group of threads for collision statistics.
     //
-    struct wait_slot
+    // In the futex-based mode (see use_futex()) the slot's mutex and
+    // condition variable are not used. Instead, the threads sleep directly
+    // on the slot's sequence number which resume() increments and wakes them
+    // up with a single system call, without taking any locks (and without
+    // the system call if there are no waiters). Note that the slots are
+    // padded to the cache line size to avoid false sharing in this mode
+    // (which is why they are allocated with aligned_array).
+    //
+    struct alignas (64) wait_slot
     {
       build2::mutex mutex;
       build2::condition_variable condv;
       size_t waiters = 0;
       const atomic_count* task_count;
       bool shutdown = true;
+
+      atomic<uint32_t>            futex_seq {0};
+      atomic<size_t>              futex_waiters {0};
+      atomic<const atomic_count*> futex_task_count {nullptr};
+      atomic<bool>                futex_shutdown {true};
     };
 
+    void
+    wake (wait_slot&);
+
     size_t wait_queue_size_; // Proportional to max_threads.
-    unique_ptr<wait_slot[]> wait_queue_;
+    aligned_array<wait_slot> wait_queue_;
 
     // Task queue.
     //
@@ -18,14 +18,20 @@ using namespace std;
 namespace build2
 {
   // Usage argv[0] [-v <volume>] [-d <difficulty>] [-c <concurrency>]
-  //               [-q <queue-depth>]
+  //               [-q <queue-depth>] [-f]
   //
   // -v  task tree volume (affects both depth and width), for example 100
   // -d  computational difficulty of each task, for example 10
   // -c  max active threads, if unspecified or 0, then hardware concurrency
   // -q  task queue depth, if unspecified or 0, then appropriate default used
+  // -f  use futex-based waiting (see scheduler::use_futex())
   //
-  // Specifying any option also turns on the verbose mode.
+  // Specifying any option also turns on the verbose mode (which includes the
+  // elapsed time). To compare the waiting implementations use a low
+  // difficulty and a high volume, for example:
+  //
+  //    $ ./driver -d 1 -v 1000
+  //    $ ./driver -d 1 -v 1000 -f
   //
   // Notes on testing:
   //
@@ -65,6 +71,7 @@ namespace build2
 
     size_t max_active (0);
     size_t queue_depth (0);
+    bool futex (false);
 
     for (int i (1); i != argc; ++i)
     {
@@ -78,6 +85,8 @@ namespace build2
         max_active = stoul (argv[++i]);
       else if (a == "-q")
         queue_depth = stoul (argv[++i]);
+      else if (a == "-f")
+        futex = true;
       else
         assert (false);
 
@@ -89,6 +98,11 @@ namespace build2
 
     scheduler s (max_active, 1, 0, queue_depth);
 
+    if (futex && !s.use_futex ())
+      cerr << "futex-based waiting not supported on this platform" << endl;
+
+    auto start (chrono::steady_clock::now ());
+
     // Find # prime counts of primes in [i, d*i*i) ranges for i in (0, n].
     //
     auto outer = [difficulty, &s] (size_t n, vector<uint64_t>& o, uint64_t& r)
@@ -130,6 +144,8 @@ namespace build2
     s.wait (task_count);
     assert (task_count == 0);
 
+    auto time (chrono::steady_clock::now () - start);
+
     uint64_t n (0);
     for (uint64_t v: r)
       n += v;
@@ -142,6 +158,9 @@ namespace build2
     if (verb)
     {
       cerr << "result                 " << n                       << endl
+           << "time                   "
+           << chrono::duration_cast<chrono::milliseconds> (time).count ()
+           << "ms" << endl
            << endl;
 
       cerr << "thread_max_active      " << st.thread_max_active     << endl
@@ -0,0 +1,241 @@
+// file      : libbuild2/target-durations.cxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#include <libbuild2/target-durations.hxx>
+
+#include <libbutl/filesystem.hxx> // file_exists()
+
+#include <libbuild2/target.hxx>
+#include <libbuild2/context.hxx>
+#include <libbuild2/diagnostics.hxx>
+
+using namespace std;
+using namespace butl;
+
+namespace build2
+{
+  // The durations file is a sequence of lines in the following form:
+  //
+  // <duration> <action> <key>
+  //
+  // Where <duration> is the own duration in nanoseconds, <action> is the
+  // numeric action id, and <key> is the target key (see key() below). The
+  // first line is the format signature.
+  //
+  static const char signature[] = "# build2 target durations 1";
+
+  void target_durations::
+  load (const path& f)
+  {
+    saved_.clear ();
+
+    try
+    {
+      if (!file_exists (f))
+        return;
+
+      ifdstream is (f, ifdstream::badbit);
+
+      string l;
+      if (eof (getline (is, l)) || l != signature)
+      {
+        warn << "invalid target durations file " << f <<
+          info << "ignoring its contents";
+        return;
+      }
+
+      while (!eof (getline (is, l)))
+      {
+        size_t p (l.find (' '));
+        if (p == string::npos || p == 0 || p + 1 == l.size ())
+        {
+          warn << "invalid line in target durations file " << f <<
+            info << "ignoring its contents";
+          saved_.clear ();
+          return;
+        }
+
+        duration::rep d (0);
+        for (size_t i (0); i != p; ++i)
+        {
+          char c (l[i]);
+          if (c < '0' || c > '9')
+          {
+            warn << "invalid duration in target durations file " << f <<
+              info << "ignoring its contents";
+            saved_.clear ();
+            return;
+          }
+
+          d = d * 10 + (c - '0');
+        }
+
+        saved_[string (l, p + 1)] = duration (d);
+      }
+    }
+    catch (const io_error& e)
+    {
+      warn << "unable to read target durations file " << f << ": " << e <<
+        info << "ignoring its contents";
+      saved_.clear ();
+    }
+    catch (const system_error& e)
+    {
+      warn << "unable to read target durations file " << f << ": " << e <<
+        info << "ignoring its contents";
+      saved_.clear ();
+    }
+  }
+
+  void target_durations::
+  save (const path& f) const
+  {
+    mlock l (mutex_);
+
+    try
+    {
+      auto_rmfile rm (f);
+      ofdstream os (f);
+
+      os << signature << '\n';
+
+      for (const auto& p: recorded_)
+        os << p.second.count () << ' ' << p.first << '\n';
+
+      for (const auto& p: saved_)
+      {
+        if (recorded_.find (p.first) == recorded_.end ())
+          os << p.second.count () << ' ' << p.first << '\n';
+      }
+
+      os.close ();
+      rm.cancel ();
+    }
+    catch (const io_error& e)
+    {
+      warn << "unable to write target durations file " << f << ": " << e;
+    }
+  }
+
+  string target_durations::
+  key (action a, const target& t)
+  {
+    string r (to_string (static_cast<uint16_t> (a.inner_id)));
+    r += '.';
+    r += to_string (static_cast<uint16_t> (a.outer_id));
+    r += ' ';
+    r += t.out_dir ().representation ();
+    r += t.type ().name;
+    r += '{';
+    r += t.name;
+    r += '}';
+    return r;
+  }
+
+  void target_durations::
+  update_max (atomic<duration::rep>& m, duration d)
+  {
+    duration::rep v (d.count ());
+    duration::rep c (m.load (memory_order_relaxed));
+
+    while (c < v && !m.compare_exchange_weak (c, v, memory_order_relaxed))
+      ; // Retry with the updated current value.
+  }
+
+  void target_durations::
+  predict (context& ctx, action a)
+  {
+    // Note that we have to reset the predictions even if there is nothing
+    // to predict (the targets may have been matched before).
+    //
+    for (const unique_ptr<target>& t: ctx.targets)
+      (*t)[a].exec_predicted = duration::min ();
+
+    if (saved_.empty ())
+      return;
+
+    for (const unique_ptr<target>& t: ctx.targets)
+      predict (a, *t);
+  }
+
+  duration target_durations::
+  predict (action a, const target& t)
+  {
+    const target::opstate& s (t[a]);
+
+    if (s.exec_predicted != duration::min ())
+      return s.exec_predicted;
+
+    s.exec_predicted = duration::zero (); // Break cycles, if any.
+
+    duration r (duration::zero ());
+    for (const target* pt: t.prerequisite_targets[a])
+    {
+      if (pt != nullptr)
+      {
+        duration d (predict (a, *pt));
+        if (d > r)
+          r = d;
+      }
+    }
+
+    auto i (saved_.find (key (a, t)));
+    if (i != saved_.end ())
+      r += i->second;
+
+    return s.exec_predicted = r;
+  }
+
+  void target_durations::
+  record (action a,
+          target& t,
+          target_state ts,
+          timestamp start,
+          timestamp end)
+  {
+    target::opstate& s (t[a]);
+
+    // Find the end of the last prerequisite and the longest prerequisite
+    // critical path.
+    //
+    timestamp b (start);
+    duration p (duration::zero ());
+
+    for (const target* pt: t.prerequisite_targets[a])
+    {
+      if (pt == nullptr)
+        continue;
+
+      const target::opstate& ps ((*pt)[a]);
+
+      timestamp e (duration (ps.exec_end.load (memory_order_relaxed)));
+      if (e > b)
+        b = e;
+
+      duration d (ps.exec_path.load (memory_order_relaxed));
+      if (d > p)
+        p = d;
+    }
+
+    duration own (end > b ? end - b : duration::zero ());
+
+    s.exec_path.store ((p + own).count (), memory_order_relaxed);
+    s.exec_end.store (end.time_since_epoch ().count (), memory_order_relaxed);
+
+    update_max (actual_path_, p + own);
+
+    if (s.exec_predicted != duration::min ())
+      update_max (predicted_path_, s.exec_predicted);
+
+    // Only update the saved duration if the target was actually changed
+    // (see the class description for details).
+    //
+    if (ts == target_state::changed)
+    {
+      string k (key (a, t));
+
+      mlock l (mutex_);
+      recorded_[move (k)] = own;
+    }
+  }
+}
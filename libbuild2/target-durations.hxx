@@ -0,0 +1,115 @@
+// file      : libbuild2/target-durations.hxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#ifndef LIBBUILD2_TARGET_DURATIONS_HXX
+#define LIBBUILD2_TARGET_DURATIONS_HXX
+
+#include <unordered_map>
+
+#include <libbuild2/types.hxx>
+#include <libbuild2/forward.hxx>
+#include <libbuild2/utility.hxx>
+
+#include <libbuild2/action.hxx>
+#include <libbuild2/target-state.hxx>
+
+#include <libbuild2/export.hxx>
+
+namespace build2
+{
+  // Target execution durations and critical path tracking.
+  //
+  // For each executed target we calculate the duration of its own work and
+  // the duration of the longest chain of such work that ends with this
+  // target (its critical path). The own work is approximated as the time
+  // between the later of the recipe start and the end of the last
+  // prerequisite (from prerequisite_targets) and the recipe end. This works
+  // well for the common case of a recipe that first executes its
+  // prerequisites and then does its own thing (compiles, links, etc).
+  //
+  // The own durations of the targets that were actually changed can be
+  // saved to a file and used in subsequent runs to predict the critical
+  // path of each target (that is, assuming it and all its prerequisites are
+  // out of date). This information is used to start prerequisites with the
+  // longest predicted critical path first so that long poles (for example, a
+  // large link) do not end up being started last (see execute_prerequisites()
+  // and straight_execute_members() for details).
+  //
+  // The durations are keyed by the action and the target's out directory,
+  // type, and name. The per-target runtime state is stored in the target's
+  // opstate (see exec_* members).
+  //
+  // Note that an instance is shared between contexts and must outlive them.
+  //
+  class LIBBUILD2_SYMEXPORT target_durations
+  {
+  public:
+    // Load durations saved by a previous run from the specified file. A
+    // non-existent file is not an error. Any other errors (including an
+    // invalid format) are diagnosed as warnings and the saved durations are
+    // ignored.
+    //
+    void
+    load (const path&);
+
+    // Save durations (previously loaded updated with the ones recorded
+    // during this run) to the specified file. Diagnose errors as warnings.
+    //
+    void
+    save (const path&) const;
+
+    // Return true if we have durations from a previous run.
+    //
+    bool
+    predicting () const {return !saved_.empty ();}
+
+    // Calculate the predicted critical paths for all the targets in the
+    // context that are matched for the specified action. Should be called
+    // serially before executing the action.
+    //
+    void
+    predict (context&, action);
+
+    // Record the execution of the target's recipe. Called by the execution
+    // machinery after the recipe has completed.
+    //
+    void
+    record (action, target&, target_state, timestamp start, timestamp end);
+
+    // Predicted and actual critical paths of this run (the longest among all
+    // the targets executed so far).
+    //
+    duration
+    predicted_path () const
+    {
+      return duration (predicted_path_.load (memory_order_relaxed));
+    }
+
+    duration
+    actual_path () const
+    {
+      return duration (actual_path_.load (memory_order_relaxed));
+    }
+
+  private:
+    duration
+    predict (action, const target&);
+
+    static string
+    key (action, const target&);
+
+    static void
+    update_max (atomic<duration::rep>&, duration);
+
+  private:
+    std::unordered_map<string, duration> saved_; // Read-only during execute.
+
+    std::unordered_map<string, duration> recorded_;
+    mutable mutex mutex_;
+
+    atomic<duration::rep> predicted_path_ {0};
+    atomic<duration::rep> actual_path_ {0};
+  };
+}
+
+#endif // LIBBUILD2_TARGET_DURATIONS_HXX
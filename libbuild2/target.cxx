@@ -3,6 +3,7 @@
 
 #include <libbuild2/target.hxx>
 
+#include <cstddef> // max_align_t
 #include <cstring> // strcmp()
 
 #include <libbuild2/file.hxx>
@@ -10,6 +11,7 @@
 #include <libbuild2/search.hxx>
 #include <libbuild2/algorithm.hxx>
 #include <libbuild2/filesystem.hxx>
+#include <libbuild2/memory-arena.hxx>
 #include <libbuild2/diagnostics.hxx>
 
 using namespace std;
@@ -83,6 +85,48 @@ namespace build2
   {
   }
 
+  // Each target allocation is prefixed with a header that records whether it
+  // came from the arena (the header size preserves the alignment).
+  //
+  static const size_t target_header (alignof (max_align_t));
+
+  void* target::
+  operator new (size_t n)
+  {
+    char* p (static_cast<char*> (::operator new (n + target_header)));
+    *p = 0;
+    return p + target_header;
+  }
+
+  void* target::
+  operator new (size_t n, context& ctx)
+  {
+    if (ctx.arena == nullptr)
+      return target::operator new (n);
+
+    char* p (static_cast<char*> (ctx.arena->allocate (n + target_header)));
+    *p = 1;
+    return p + target_header;
+  }
+
+  void target::
+  operator delete (void* p)
+  {
+    if (p != nullptr)
+    {
+      char* b (static_cast<char*> (p) - target_header);
+
+      if (*b == 0) // Otherwise released with the arena.
+        ::operator delete (b);
+    }
+  }
+
+  void target::
+  operator delete (void* p, context&)
+  {
+    target::operator delete (p);
+  }
+
   const string& target::
   ext (string v)
   {
@@ -746,6 +746,12 @@ namespace build2
     class LIBBUILD2_SYMEXPORT opstate
     {
     public:
+      // Note that the data members are ordered so that the ones accessed
+      // during execute (and, in particular, the no-op execute of an
+      // up-to-date target) are next to each other at the beginning of the
+      // object and normally fit into a single cache line. The rest (match
+      // state, timing, rule-specific variables) follow.
+      //
       mutable atomic_count task_count {0}; // Start offset_touched - 1.
 
       // Number of direct targets that depend on this target in the current
@@ -756,35 +762,43 @@ namespace build2
       //
       mutable atomic_count dependents {0};
 
-      // Match state storage between the match() and apply() calls.
-      //
-      build2::match_extra match_extra;
-
       // Matched rule (pointer to name_rule_map element). Note that in case of
       // a direct recipe assignment we may not have a rule (NULL).
       //
       const rule_match* rule;
 
+      // Target state for this operation. Note that it is undetermined until
+      // a rule is matched and recipe applied (see set_recipe()).
+      //
+      target_state state;
+
+      // Set to true (only for the inner action) if this target has been
+      // matched but not executed as a result of the resolve_members() call.
+      // See also context::resolve_count.
+      //
+      bool resolve_counted;
+
       // Applied recipe.
       //
       // Note: also used as the auxiliary data storage during match, which is
       //       why mutable (see the target::data() API below for details). The
       //       default recipe_keep value is set by clear_target().
       //
-      mutable build2::recipe recipe;
       mutable bool           recipe_keep;         // Keep after execution.
       bool                   recipe_group_action; // Recipe is group_action.
+      mutable build2::recipe recipe;
 
-      // Target state for this operation. Note that it is undetermined until
-      // a rule is matched and recipe applied (see set_recipe()).
+      // Match state storage between the match() and apply() calls.
       //
-      target_state state;
+      build2::match_extra match_extra;
 
-      // Set to true (only for the inner action) if this target has been
-      // matched but not executed as a result of the resolve_members() call.
-      // See also context::resolve_count.
+      // Execution timing (see target_durations for details). The end time
+      // and the critical path are only set if the durations are tracked.
+      // The predicted critical path is duration::min() if unknown.
       //
-      bool resolve_counted;
+      mutable atomic<timestamp::rep> exec_end  {0};
+      mutable atomic<duration::rep>  exec_path {0};
+      mutable duration               exec_predicted {duration::min ()};
 
       // Rule-specific variables.
       //
@@ -1217,6 +1231,27 @@ namespace build2
 
     virtual
     ~target ();
+
+    // Allocation.
+    //
+    // If the context has the memory arena (see context::arena), then targets
+    // created with the context placement form (as done by target_factory())
+    // are allocated from it and their memory is released all at once when
+    // the context is destroyed. Otherwise (including targets created with
+    // plain new, for example, by external modules) the memory is allocated
+    // and released as usual.
+    //
+    static void*
+    operator new (size_t);
+
+    static void*
+    operator new (size_t, context&);
+
+    static void
+    operator delete (void*);
+
+    static void
+    operator delete (void*, context&);
   };
 
   // All targets are from the targets set below.
@@ -2460,7 +2495,7 @@ namespace build2
   target_factory (context& c,
                   const target_type&, dir_path d, dir_path o, string n)
   {
-    return new T (c, move (d), move (o), move (n));
+    return new (c) T (c, move (d), move (o), move (n));
   }
 
   // Return fixed target extension unless one was specified.
@@ -0,0 +1,215 @@
+// file      : libbuild2/target.test.cxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#include <chrono>
+
+#include <iostream>
+
+#include <libbuild2/types.hxx>
+#include <libbuild2/utility.hxx>
+
+#include <libbuild2/action.hxx>
+#include <libbuild2/recipe.hxx>
+#include <libbuild2/target.hxx>
+#include <libbuild2/context.hxx>
+#include <libbuild2/algorithm.hxx>
+#include <libbuild2/operation.hxx>
+#include <libbuild2/scheduler.hxx>
+#include <libbuild2/file-cache.hxx>
+#include <libbuild2/diagnostics.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+
+namespace build2
+{
+  // Usage argv[0] [-n <targets>] [-i <iterations>] [-c <concurrency>]
+  //
+  // -n  number of targets, for example 100000
+  // -i  number of execute iterations, for example 10
+  // -c  max active threads, if unspecified or 0, then hardware concurrency
+  //
+  // Specifying any option also turns on the verbose mode which prints the
+  // execute throughput.
+  //
+  // This is a microbenchmark of the target state access during the execute
+  // phase. It executes a set of real targets with execute_async() and
+  // execute_complete() (see algorithm.hxx), similar to how prerequisites are
+  // executed, but without the overhead of matching rules, prerequisites,
+  // etc. Every other target has the noop recipe (as is the case for most
+  // targets in a no-op build) with the rest having a real recipe that goes
+  // through execute_impl(). See also scheduler.test.cxx for notes on
+  // testing.
+  //
+  static atomic<size_t> executed (0);
+
+  static target_state
+  update (action, const target&)
+  {
+    executed.fetch_add (1, memory_order_relaxed);
+    return target_state::changed;
+  }
+
+  int
+  main (int argc, char* argv[])
+  {
+    bool verb (false);
+
+    size_t targets (10000);
+    size_t iterations (2);
+    size_t max_active (0);
+
+    for (int i (1); i != argc; ++i)
+    {
+      string a (argv[i]);
+
+      if (a == "-n")
+        targets = stoul (argv[++i]);
+      else if (a == "-i")
+        iterations = stoul (argv[++i]);
+      else if (a == "-c")
+        max_active = stoul (argv[++i]);
+      else
+        assert (false);
+
+      verb = true;
+    }
+
+    if (max_active == 0)
+      max_active = scheduler::hardware_concurrency ();
+
+    // Fake build system driver, default verbosity.
+    //
+    init_diag (1);
+    init (nullptr, argv[0], true);
+
+    scheduler sched (max_active, 1, 0, 0);
+    global_mutexes mutexes (sched.shard_size ());
+    file_cache fcache (true);
+    context ctx (sched, mutexes, fcache);
+
+    tracer trace ("main");
+
+    ctx.current_meta_operation (mo_perform);
+    ctx.current_operation (op_update);
+
+    action a (perform_id, update_id);
+    dir_path d ("/tmp/build/");
+
+    vector<target*> ts;
+    ts.reserve (targets);
+
+    for (size_t i (0); i != targets; ++i)
+    {
+      file& t (ctx.targets.insert<file> (d,
+                                         dir_path (),
+                                         "t" + to_string (i),
+                                         string ("o"),
+                                         trace));
+
+      target::opstate& s (t[a]);
+      s.rule = nullptr;
+      s.resolve_counted = false;
+      s.recipe_keep = false;
+      s.recipe_group_action = false;
+
+      ts.push_back (&t);
+    }
+
+    phase_lock pl (ctx, run_phase::execute);
+
+    duration time (duration::zero ());
+
+    for (size_t i (0); i != iterations; ++i)
+    {
+      // Reset the state to what it would be after match (see set_recipe()
+      // for details).
+      //
+      size_t n (0); // Number of targets with a real recipe.
+
+      for (size_t j (0); j != targets; ++j)
+      {
+        target::opstate& s ((*ts[j])[a]);
+
+        if (j % 2 == 0)
+        {
+          s.recipe = noop_recipe;
+          s.state = target_state::unchanged;
+        }
+        else
+        {
+          s.recipe = &update;
+          s.state = target_state::unknown;
+          ++n;
+        }
+
+        s.task_count.store (ctx.count_applied (), memory_order_relaxed);
+        s.dependents.store (1, memory_order_relaxed);
+      }
+
+      ctx.dependency_count.store (targets, memory_order_relaxed);
+      ctx.target_count.store (n, memory_order_relaxed);
+      executed.store (0, memory_order_relaxed);
+
+      scheduler::atomic_count task_count (0);
+
+      auto start (system_clock::now ());
+
+      for (const target* t: ts)
+        execute_async (a, *t, 0 /* start_count */, task_count);
+
+      sched.wait (task_count);
+      assert (task_count == 0);
+
+      for (const target* t: ts)
+        execute_complete (a, *t);
+
+      time += system_clock::now () - start;
+
+      assert (ctx.dependency_count == 0 &&
+              ctx.target_count == 0     &&
+              executed == n);
+
+      for (size_t j (0); j != targets; ++j)
+      {
+        const target& t (*ts[j]);
+        const target::opstate& s (t[a]);
+
+        assert (s.task_count == ctx.count_executed () && s.dependents == 0);
+
+        // The recipe is cleared after it has been executed.
+        //
+        assert ((s.recipe != nullptr) == (j % 2 == 0));
+
+        assert (t.executed_state (a) == (j % 2 == 0
+                                         ? target_state::unchanged
+                                         : target_state::changed));
+      }
+    }
+
+    if (verb)
+    {
+      double us (
+        chrono::duration_cast<chrono::microseconds> (time).count ());
+
+      cerr << "targets                " << targets    << endl
+           << "iterations             " << iterations << endl
+           << "opstate size           " << sizeof (target::opstate) << endl
+           << endl
+           << "execute time           " << us / 1000 << "ms" << endl
+           << "execute throughput     "
+           << (us != 0 ? targets * iterations / us : 0) << " targets/us"
+           << endl;
+    }
+
+    return 0;
+  }
+}
+
+int
+main (int argc, char* argv[])
+{
+  return build2::main (argc, argv);
+}
@@ -0,0 +1,300 @@
+// file      : libbuild2/timeline.cxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#include <libbuild2/timeline.hxx>
+
+#include <sstream>
+
+#ifndef BUILD2_BOOTSTRAP
+#  include <libbutl/json/serializer.hxx>
+#endif
+
+#include <libbuild2/target.hxx>
+#include <libbuild2/diagnostics.hxx>
+
+using namespace std;
+using namespace butl;
+
+namespace build2
+{
+  timeline* build_timeline = nullptr;
+
+  // Note that the buffer is associated with the timeline instance that
+  // created it and which is identified by its (process-unique) id rather
+  // than address, so that a buffer that belongs to a destroyed instance is
+  // never reused.
+  //
+  static atomic<size_t> timeline_id (0);
+
+  static
+#ifdef __cpp_thread_local
+  thread_local
+#else
+  __thread
+#endif
+  timeline::thread_buffer* timeline_buffer = nullptr;
+
+  static
+#ifdef __cpp_thread_local
+  thread_local
+#else
+  __thread
+#endif
+  size_t timeline_buffer_id = 0;
+
+  struct timeline::output
+  {
+    ofdstream os;
+
+#ifndef BUILD2_BOOTSTRAP
+    json::stream_serializer js;
+
+    output (): js (os, 0 /* indentation */) {}
+#endif
+  };
+
+  timeline::
+  timeline (path f)
+      : file_ (move (f)),
+        start_ (system_clock::now ()),
+        id_ (++timeline_id),
+        out_ (new output)
+  {
+    try
+    {
+      out_->os.open (file_);
+
+#ifndef BUILD2_BOOTSTRAP
+      json::stream_serializer& js (out_->js);
+
+      js.begin_object ();
+      js.member ("displayTimeUnit", "ms");
+      js.member_begin_array ("traceEvents");
+#endif
+    }
+    catch (const io_error& e)
+    {
+      fail << "unable to write " << file_ << ": " << e;
+    }
+  }
+
+  timeline::
+  ~timeline ()
+  {
+    // Normally close() should have been called. If not, then we are failing
+    // and leaving an incomplete file behind is the best we can do.
+  }
+
+  timeline::thread_buffer& timeline::
+  buffer ()
+  {
+    if (timeline_buffer_id == id_)
+      return *timeline_buffer;
+
+    mlock l (buffers_mutex_);
+
+    buffers_.push_back (thread_buffer {buffers_.size () + 1, {}});
+    thread_buffer& b (buffers_.back ());
+    b.events.reserve (1024);
+
+    timeline_buffer_id = id_;
+    return *(timeline_buffer = &b);
+  }
+
+  void timeline::
+  record (category c, timestamp s, timestamp e, action a, const target& t)
+  {
+    buffer ().events.push_back (
+      event {c, a, &t, nullptr, string (), 0,
+             s.time_since_epoch ().count (),
+             e.time_since_epoch ().count ()});
+  }
+
+  void timeline::
+  record (category c, timestamp s, timestamp e, const char* n)
+  {
+    buffer ().events.push_back (
+      event {c, action (), nullptr, n, string (), 0,
+             s.time_since_epoch ().count (),
+             e.time_since_epoch ().count ()});
+  }
+
+  void timeline::
+  process_start (process::id_type id, const char* p)
+  {
+    size_t tid (buffer ().tid);
+    timestamp::rep s (system_clock::now ().time_since_epoch ().count ());
+
+    // Only keep the program name (without the directory).
+    //
+    const char* n (p);
+    for (const char* c (p); *c != '\0'; ++c)
+    {
+      if (path::traits_type::is_separator (*c))
+        n = c + 1;
+    }
+
+    mlock l (processes_mutex_);
+    processes_[id] = process_entry {n, tid, s};
+  }
+
+  void timeline::
+  process_finish (process::id_type id)
+  {
+    timestamp::rep e (system_clock::now ().time_since_epoch ().count ());
+
+    process_entry pe;
+    {
+      mlock l (processes_mutex_);
+
+      auto i (processes_.find (id));
+      if (i == processes_.end ())
+        return;
+
+      pe = move (i->second);
+      processes_.erase (i);
+    }
+
+    buffer ().events.push_back (
+      event {category::process, action (), nullptr, nullptr,
+             move (pe.prog), pe.tid,
+             pe.begin,
+             e});
+  }
+
+  static const char*
+  to_string (timeline::category c)
+  {
+    using category = timeline::category;
+
+    switch (c)
+    {
+    case category::match:   return "match";
+    case category::apply:   return "apply";
+    case category::execute: return "execute";
+    case category::process: return "process";
+    case category::phase:   return "phase";
+    case category::wait:    return "wait";
+    }
+
+    return "";
+  }
+
+  void timeline::
+  write (const event& e, size_t tid)
+  {
+#ifndef BUILD2_BOOTSTRAP
+    using chrono::microseconds;
+    using chrono::duration_cast;
+
+    json::stream_serializer& js (out_->js);
+
+    duration b (duration (e.begin) - start_.time_since_epoch ());
+    duration d (e.end > e.begin ? duration (e.end - e.begin) : duration (0));
+
+    js.begin_object ();
+
+    if (e.tgt != nullptr)
+    {
+      ostringstream os;
+      os << *e.tgt;
+      js.member ("name", os.str ());
+    }
+    else if (e.name != nullptr)
+      js.member ("name", e.name);
+    else
+      js.member ("name", e.prog);
+
+    js.member ("cat", to_string (e.cat));
+    js.member ("ph", "X");
+    js.member ("ts",  static_cast<int64_t> (
+                        duration_cast<microseconds> (b).count ()));
+    js.member ("dur", static_cast<int64_t> (
+                        duration_cast<microseconds> (d).count ()));
+    js.member ("pid", static_cast<uint64_t> (1));
+    js.member ("tid", static_cast<uint64_t> (
+                        e.cat == category::process ? e.tid : tid));
+
+    if (e.tgt != nullptr)
+    {
+      ostringstream os;
+      os << e.act;
+
+      js.member_begin_object ("args");
+      js.member ("action", os.str ());
+      js.end_object ();
+    }
+
+    js.end_object ();
+#else
+    (void) e; (void) tid;
+#endif
+  }
+
+  void timeline::
+  flush ()
+  {
+    // Note that we may be called from the context destructor so we don't
+    // throw but instead issue a warning and stop writing. This includes the
+    // serialization errors (for example, a target name that is not valid
+    // UTF-8) since at that point the JSON output is incomplete and we
+    // cannot recover.
+    //
+    for (thread_buffer& b: buffers_)
+    {
+      if (!failed_)
+      try
+      {
+        for (const event& e: b.events)
+          write (e, b.tid);
+      }
+      catch (const io_error& e)
+      {
+        warn << "unable to write " << file_ << ": " << e;
+        failed_ = true;
+      }
+#ifndef BUILD2_BOOTSTRAP
+      catch (const json::invalid_json_output& e)
+      {
+        warn << "invalid " << file_ << " json output: " << e;
+        failed_ = true;
+      }
+#endif
+
+      b.events.clear ();
+    }
+
+    // Drop the processes that were started but whose finish was never
+    // recorded (for example, because they were waited for directly rather
+    // than with run_finish()). By now (all the threads are quiescent) they
+    // are no longer running.
+    //
+    processes_.clear ();
+  }
+
+  void timeline::
+  close ()
+  {
+    flush ();
+
+    if (failed_)
+      return;
+
+    try
+    {
+#ifndef BUILD2_BOOTSTRAP
+      json::stream_serializer& js (out_->js);
+      js.end_array ();
+      js.end_object ();
+#endif
+
+      out_->os << '\n';
+      out_->os.close ();
+    }
+    catch (const io_error& e)
+    {
+      warn << "unable to write " << file_ << ": " << e;
+      failed_ = true;
+    }
+  }
+}
@@ -0,0 +1,181 @@
+// file      : libbuild2/timeline.hxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#ifndef LIBBUILD2_TIMELINE_HXX
+#define LIBBUILD2_TIMELINE_HXX
+
+#include <list>
+
+#include <libbuild2/types.hxx>
+#include <libbuild2/forward.hxx>
+#include <libbuild2/utility.hxx>
+
+#include <libbuild2/action.hxx>
+
+#include <libbuild2/export.hxx>
+
+namespace build2
+{
+  // Build timeline recorder (see the --trace option).
+  //
+  // Records the match, apply, and execute steps of each target, external
+  // processes, phase switch waits, and scheduler waits and writes them as a
+  // Chrome trace (JSON) that can be viewed with chrome://tracing or Perfetto.
+  //
+  // Recording is designed to be cheap enough to be left enabled: each thread
+  // appends events to its own buffer without any synchronization (the
+  // buffers are only registered, under a mutex, on the first event of each
+  // thread). Events refer to targets by pointer and target names are only
+  // resolved when the buffers are flushed to the file, which happens when a
+  // build context is destroyed (at which point all the threads are
+  // quiescent). Processes are matched between run_start() and run_finish()
+  // by their process id.
+  //
+  class LIBBUILD2_SYMEXPORT timeline
+  {
+  public:
+    enum class category: uint8_t
+    {
+      match,
+      apply,
+      execute,
+      process,
+      phase,
+      wait
+    };
+
+    // Open the trace file for writing and write the header. Fail if unable
+    // to do so.
+    //
+    explicit
+    timeline (path);
+
+    ~timeline ();
+
+    // Record a complete event for a target or with a static name.
+    //
+    void
+    record (category, timestamp start, timestamp end, action, const target&);
+
+    void
+    record (category, timestamp start, timestamp end, const char* name);
+
+    // Record the start and finish of an external process.
+    //
+    void
+    process_start (process::id_type, const char* program);
+
+    void
+    process_finish (process::id_type);
+
+    // Write all the recorded events to the file. Must be called serially and
+    // before any of the targets referenced by the events are destroyed.
+    // Diagnose errors as warnings and stop writing.
+    //
+    void
+    flush ();
+
+    // Flush and write the trailer.
+    //
+    void
+    close ();
+
+  public:
+    struct event
+    {
+      category       cat;
+      action         act;  // match, apply, execute
+      const target*  tgt;  // match, apply, execute
+      const char*    name; // Static name or NULL.
+      string         prog; // process
+      size_t         tid;  // process (thread that started it)
+      timestamp::rep begin;
+      timestamp::rep end;
+    };
+
+    struct thread_buffer
+    {
+      size_t        tid;
+      vector<event> events;
+    };
+
+  private:
+    thread_buffer&
+    buffer ();
+
+    void
+    write (const event&, size_t tid);
+
+  private:
+    path file_;
+    timestamp start_;
+    size_t id_; // Instance id (see timeline.cxx).
+    bool failed_ = false;
+
+    std::list<thread_buffer> buffers_; // Node stability.
+    mutex buffers_mutex_;
+
+    struct process_entry
+    {
+      string         prog;
+      size_t         tid;
+      timestamp::rep begin;
+    };
+
+    map<process::id_type, process_entry> processes_;
+    mutex processes_mutex_;
+
+    // Output state (see timeline.cxx).
+    //
+    struct output;
+    unique_ptr<output> out_;
+  };
+
+  // The timeline instance, if enabled.
+  //
+  LIBBUILD2_SYMEXPORT extern timeline* build_timeline;
+
+  // Record the enclosing scope as a timeline event, if enabled.
+  //
+  class timeline_scope
+  {
+  public:
+    timeline_scope (timeline::category c, action a, const target& t)
+        : tl_ (build_timeline), cat_ (c), act_ (a), tgt_ (&t), name_ (nullptr)
+    {
+      if (tl_ != nullptr)
+        start_ = system_clock::now ();
+    }
+
+    timeline_scope (timeline::category c, const char* n)
+        : tl_ (build_timeline), cat_ (c), tgt_ (nullptr), name_ (n)
+    {
+      if (tl_ != nullptr)
+        start_ = system_clock::now ();
+    }
+
+    ~timeline_scope ()
+    {
+      if (tl_ != nullptr)
+      {
+        if (tgt_ != nullptr)
+          tl_->record (cat_, start_, system_clock::now (), act_, *tgt_);
+        else
+          tl_->record (cat_, start_, system_clock::now (), name_);
+      }
+    }
+
+    timeline_scope (const timeline_scope&) = delete;
+    timeline_scope& operator= (const timeline_scope&) = delete;
+
+  private:
+    timeline*          tl_;
+    timeline::category cat_;
+    action             act_;
+    const target*      tgt_;
+    const char*        name_;
+    timestamp          start_;
+  };
+}
+
+#endif // LIBBUILD2_TIMELINE_HXX
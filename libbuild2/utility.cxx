@@ -21,6 +21,7 @@
 
 #include <libbuild2/target.hxx>
 #include <libbuild2/context.hxx>
+#include <libbuild2/timeline.hxx>
 #include <libbuild2/variable.hxx>
 #include <libbuild2/diagnostics.hxx>
 
@@ -227,7 +228,7 @@ namespace build2
     if (verb >= verbosity)
       print_process (pe, args, 0);
 
-    return process (
+    process pr (
       *pe.path,
       args,
       in,
@@ -235,6 +236,11 @@ namespace build2
       err,
       pe.cwd != nullptr ? pe.cwd->string ().c_str () : nullptr,
       pe.vars);
+
+    if (build_timeline != nullptr)
+      build_timeline->process_start (pr.id (), args[0]);
+
+    return pr;
   }
   catch (const process_error& e)
   {
@@ -254,10 +260,35 @@ namespace build2
       fail (l) << "unable to execute " << args[0] << ": " << e << endf;
   }
 
+  // Record the process finish in the timeline, if enabled, once the
+  // process has been waited for.
+  //
+  namespace
+  {
+    class timeline_process
+    {
+    public:
+      explicit
+      timeline_process (const process& pr)
+          : tl_ (build_timeline), id_ (tl_ != nullptr ? pr.id () : 0) {}
+
+      ~timeline_process ()
+      {
+        if (tl_ != nullptr)
+          tl_->process_finish (id_);
+      }
+
+    private:
+      timeline*        tl_;
+      process::id_type id_;
+    };
+  }
+
   bool
   run_wait (const char* const* args, process& pr, const location& loc)
   try
   {
+    timeline_process tlp (pr);
     return pr.wait ();
   }
   catch (const process_error& e)
@@ -278,6 +309,10 @@ namespace build2
 
     try
     {
+      // Note that the process id is no longer available after wait().
+      //
+      timeline_process tlp (pr);
+
       if (pr.wait ())
         return true;
     }
@@ -346,6 +381,7 @@ namespace build2
   {
     try
     {
+      timeline_process tlp (pr);
       pr.wait ();
     }
     catch (const process_error& e)
@@ -5,6 +5,7 @@
 #define LIBBUILD2_UTILITY_HXX
 
 #include <tuple>       // make_tuple()
+#include <new>         // operator new/delete
 #include <memory>      // make_shared()
 #include <string>      // to_string()
 #include <utility>     // move(), forward(), declval(), make_pair(), swap()
@@ -1094,6 +1095,45 @@ namespace build2
   //
   optional<uint64_t>
   parse_number (const string&, uint64_t max = UINT64_MAX);
+
+  // Dynamically-allocated array of objects with an extended alignment (for
+  // example, padded to the cache line size with alignas). Before C++17 the
+  // array new expression is not required to honor such an alignment so we
+  // over-allocate and align the storage ourselves.
+  //
+  template <typename T>
+  class aligned_array
+  {
+  public:
+    aligned_array () = default;
+
+    explicit
+    aligned_array (size_t n) {reset (n);}
+
+    ~aligned_array () {reset ();}
+
+    // Destroy the current elements, if any, and allocate n default-
+    // constructed ones.
+    //
+    void
+    reset (size_t n = 0);
+
+    T&
+    operator[] (size_t i) {return data_[i];}
+
+    const T&
+    operator[] (size_t i) const {return data_[i];}
+
+    explicit operator bool () const {return data_ != nullptr;}
+
+    aligned_array (const aligned_array&) = delete;
+    aligned_array& operator= (const aligned_array&) = delete;
+
+  private:
+    void*  buf_  = nullptr;
+    T*     data_ = nullptr;
+    size_t size_ = 0;
+  };
 }
 
 #include <libbuild2/utility.ixx>
@@ -54,4 +54,36 @@ namespace build2
 
     return p;
   }
+
+  template <typename T>
+  void aligned_array<T>::
+  reset (size_t n)
+  {
+    for (; size_ != 0; --size_)
+      data_[size_ - 1].~T ();
+
+    ::operator delete (buf_);
+    buf_ = nullptr;
+    data_ = nullptr;
+
+    if (n != 0)
+    {
+      const uintptr_t a (alignof (T));
+
+      buf_ = ::operator new (n * sizeof (T) + a - 1);
+      data_ = reinterpret_cast<T*> (
+        (reinterpret_cast<uintptr_t> (buf_) + a - 1) & ~(a - 1));
+
+      try
+      {
+        for (; size_ != n; ++size_)
+          new (data_ + size_) T ();
+      }
+      catch (...)
+      {
+        reset ();
+        throw;
+      }
+    }
+  }
 }
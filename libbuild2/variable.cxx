@@ -368,13 +368,12 @@ namespace build2
   {
     // Typification is kind of like caching so we reuse that mutex shard.
     //
-    shared_mutex& m (
-      ctx.mutexes->variable_cache[
-        hash<value*> () (&v) % ctx.mutexes->variable_cache_size]);
+    global_mutexes::shard& s (ctx.mutexes->variable_cache_shard (&v));
 
     // Note: v.type is rechecked by typify() under lock.
     //
-    ulock l (m);
+    ulock l (s.mutex, defer_lock);
+    s.lock (l);
     typify (v, t, var, memory_order_release);
   }
 
@@ -1866,6 +1865,37 @@ namespace build2
     return pair<variable&, bool> (var, r.second);
   }
 
+  void variable_pool::
+  freeze ()
+  {
+    size_t n (ids_.size ());
+
+    if (n == frozen_n_)
+      return;
+
+    // Keep the load factor at or below 0.5 so that the probe sequences are
+    // short.
+    //
+    size_t c (16);
+    for (; c < n * 2; c <<= 1) ;
+
+    vector<frozen_slot> t (c, frozen_slot {0, nullptr});
+    size_t m (c - 1);
+
+    for (const variable* v: ids_)
+    {
+      size_t h (std::hash<string> () (v->name));
+
+      size_t i (h & m);
+      for (; t[i].var != nullptr; i = (i + 1) & m) ;
+
+      t[i] = frozen_slot {h, v};
+    }
+
+    frozen_ = move (t);
+    frozen_n_ = n;
+  }
+
   const variable& variable_pool::
   insert_alias (const variable& var, string n)
   {
@@ -229,6 +229,13 @@ namespace build2
     unique_ptr<const variable> overrides;
     variable_visibility visibility;
 
+    // Dense numeric id assigned by the owning pool on insertion, starting
+    // from 1 (0 means no id, which is the case for overrides and temporary
+    // variables). Can be used for direct indexing (see variable_pool::find()
+    // with the id argument).
+    //
+    size_t id = 0;
+
     // Return true if this variable is an alias of the specified variable.
     //
     bool
@@ -1279,9 +1286,41 @@ namespace build2
 
     // Return NULL if there is no variable with this name.
     //
+    // If the pool has been frozen (see freeze() below) and hasn't changed
+    // since, then this lookup is performed using the immutable snapshot.
+    //
     const variable*
     find (const string& name) const;
 
+    // Return the variable with the specified id (see variable::id) that
+    // belongs to this pool or NULL if there is no such variable.
+    //
+    const variable*
+    find (size_t id) const
+    {
+      return id != 0 && id <= ids_.size () ? ids_[id - 1] : nullptr;
+    }
+
+    // The number of variables in this pool (and the largest id).
+    //
+    size_t
+    size () const {return ids_.size ();}
+
+    // Freeze the current pool state into an immutable snapshot (open
+    // addressing hash table with precomputed hashes) that is used for the
+    // lookups by name until the pool changes. This is normally done at the
+    // end of each load phase (see run_phase_mutex) so that the lookups
+    // during match and execute don't go through the map. Note that the pool
+    // can only grow and only during load.
+    //
+    void
+    freeze ();
+
+    // Return true if the snapshot is current and is used by find().
+    //
+    bool
+    frozen () const {return frozen_n_ != 0 && frozen_n_ == ids_.size ();}
+
     // Find existing or insert new variable.
     //
     // Unless specified explicitly, the variable is untyped, non-overridable,
@@ -1471,6 +1510,9 @@ namespace build2
             const variable_visibility*,
             const bool*) const;
 
+    const variable*
+    find_own (const string&) const;
+
     // Variable map.
     //
   private:
@@ -1487,6 +1529,9 @@ namespace build2
 
       if (r.second)
       {
+        ids_.push_back (&r.first->second);
+        r.first->second.id = ids_.size ();
+
 #if 0
         if (shared_ && outer_ == nullptr) // Global pool in context.
         {
@@ -1513,6 +1558,17 @@ namespace build2
     const variable_patterns* patterns_;
     map map_;
 
+    vector<const variable*> ids_; // Variables by id - 1.
+
+    struct frozen_slot
+    {
+      size_t hash;
+      const variable* var; // NULL if empty.
+    };
+
+    vector<frozen_slot> frozen_;      // Power of 2 size.
+    size_t              frozen_n_ = 0; // Pool size at the time of freeze.
+
 #if 0
     size_t buckets_ = 0;
 #endif
@@ -908,24 +908,43 @@ namespace build2
 
   // variable_pool
   //
+  inline const variable* variable_pool::
+  find_own (const string& n) const
+  {
+    // Note that the pool can only grow so if the size hasn't changed, then
+    // the snapshot is current.
+    //
+    if (frozen ())
+    {
+      size_t h (std::hash<string> () (n));
+      size_t m (frozen_.size () - 1);
+
+      for (size_t i (h & m);; i = (i + 1) & m)
+      {
+        const frozen_slot& s (frozen_[i]);
+
+        if (s.var == nullptr)
+          return nullptr;
+
+        if (s.hash == h && s.var->name == n)
+          return s.var;
+      }
+    }
+
+    auto i (map_.find (&n));
+    return i != map_.end () ? &i->second : nullptr;
+  }
+
   inline const variable* variable_pool::
   find (const string& n) const
   {
     // The pool chaining semantics for lookup: first check own pool then, if
     // not found, check the outer pool.
     //
-    auto i (map_.find (&n));
-    if (i != map_.end ())
-      return &i->second;
-
-    if (outer_ != nullptr)
-    {
-      i = outer_->map_.find (&n);
-      if (i != outer_->map_.end ())
-        return &i->second;
-    }
+    if (const variable* r = find_own (n))
+      return r;
 
-    return nullptr;
+    return outer_ != nullptr ? outer_->find_own (n) : nullptr;
   }
 
   inline const variable& variable_pool::
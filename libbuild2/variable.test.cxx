@@ -0,0 +1,81 @@
+// file      : libbuild2/variable.test.cxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#include <libbuild2/types.hxx>
+#include <libbuild2/utility.hxx>
+
+#include <libbuild2/context.hxx>
+#include <libbuild2/variable.hxx>
+#include <libbuild2/scheduler.hxx>
+#include <libbuild2/file-cache.hxx>
+#include <libbuild2/diagnostics.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+
+namespace build2
+{
+  int
+  main (int, char* argv[])
+  {
+    // Fake build system driver, default verbosity.
+    //
+    init_diag (1);
+    init (nullptr, argv[0], true);
+
+    scheduler sched (1);
+    global_mutexes mutexes (1);
+    file_cache fcache (true);
+    context ctx (sched, mutexes, fcache);
+
+    const variable_pool& vp (ctx.var_pool);
+
+    // Serial load: the pool is not frozen and lookups go to the map.
+    //
+    const variable& x (vp.rw ().insert ("test.x"));
+    assert (x.id != 0 && vp.find (x.id) == &x);
+    assert (!vp.frozen ());
+    assert (vp.find ("test.x") == &x);
+
+    // Switching from the serial load to match freezes the pool.
+    //
+    {
+      phase_lock pl (ctx, run_phase::match);
+
+      assert (vp.frozen ());
+      assert (vp.find ("test.x") == &x);
+      assert (vp.find ("test.y") == nullptr);
+
+      for (size_t i (1); i <= vp.size (); ++i)
+      {
+        const variable* v (vp.find (i));
+        assert (v != nullptr && v->id == i && vp.find (v->name) == v);
+      }
+
+      // Interim load: new variables invalidate the snapshot until the load
+      // lock is released.
+      //
+      {
+        phase_switch ps (ctx, run_phase::load);
+
+        const variable& y (vp.rw ().insert ("test.y"));
+        assert (!vp.frozen ());
+        assert (vp.find ("test.y") == &y);
+      }
+
+      assert (vp.frozen ());
+      assert (vp.find ("test.y") != nullptr);
+      assert (vp.find ("test.z") == nullptr);
+    }
+
+    return 0;
+  }
+}
+
+int
+main (int argc, char* argv[])
+{
+  return build2::main (argc, argv);
+}
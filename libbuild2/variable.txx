@@ -1018,12 +1018,12 @@ namespace build2
                  ? static_cast<const value_data*> (stem.value)->version
                  : 0);
 
-    shared_mutex& m (
-      ctx.mutexes->variable_cache[
-        hash<variable_cache*> () (this) % ctx.mutexes->variable_cache_size]);
+    global_mutexes::shard& s (ctx.mutexes->variable_cache_shard (this));
 
-    slock sl (m);
-    ulock ul (m, defer_lock);
+    slock sl (s.mutex, defer_lock);
+    ulock ul (s.mutex, defer_lock);
+
+    s.lock (sl);
 
     auto i (m_.find (k));
 
@@ -1040,7 +1040,7 @@ namespace build2
     // that between unlock and lock someone else has updated the entry.
     //
     sl.unlock ();
-    ul.lock ();
+    s.lock (ul);
 
     // Note that the cache entries are never removed so we can reuse the
     // iterator.
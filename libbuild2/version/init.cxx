@@ -266,7 +266,17 @@ namespace build2
       bool rewritten (false);
       if (v.snapshot () && v.snapshot_sn == standard_version::latest_sn)
       {
-        snapshot ss (extract_snapshot (rs));
+        // Cache the snapshot information on disk if requested (off by
+        // default since it means writing into the user's repository).
+        //
+        // Note that we are normally booted before the config module so this
+        // can only come from the command line (or default options file).
+        //
+        const variable& cv (
+          rs.var_pool (true /* public */).insert<bool> (
+            "config.version.snapshot_cache"));
+
+        snapshot ss (extract_snapshot (rs, cast_false<bool> (rs[cv])));
 
         if (!ss.empty ())
         {
@@ -20,7 +20,10 @@ namespace build2
     class in_rule: public in::rule
     {
     public:
-      in_rule (): rule ("version.in 2", "version") {}
+      in_rule ()
+          : rule ("version.in 2", "version",
+                  '$', true /* strict */, nullopt /* null */,
+                  true /* memoize */) {}
 
       virtual bool
       match (action, target&) const override;
@@ -4,6 +4,7 @@
 #include <ctime> // time_t
 
 #include <libbutl/sha1.hxx>
+#include <libbutl/filesystem.hxx> // file_exists(), dir_exists()
 
 #include <libbuild2/version/snapshot.hxx>
 
@@ -14,15 +15,178 @@ namespace build2
 {
   namespace version
   {
-    // We have to run git twice to extract the information we need and doing
-    // it repetitively is quite expensive, especially for larger repositories.
-    // So we cache it, which helps multi-package repositories.
+    // We have to run git (up to) twice to extract the information we need and
+    // doing it repetitively is quite expensive, especially for larger
+    // repositories. So we cache it, which helps multi-package repositories.
+    // See also the on-disk commit information cache below.
     //
     static global_cache<snapshot, dir_path> cache;
 
+    // Return the first line of a file or nullopt if it does not exist or
+    // cannot be read.
+    //
+    static optional<string>
+    read_line (const path& f)
+    {
+      try
+      {
+        ifdstream is (f, ifdstream::badbit);
+
+        string l;
+        getline (is, l);
+        is.close ();
+
+        return l;
+      }
+      catch (const io_error&)
+      {
+        return nullopt;
+      }
+    }
+
+    // Return true if this looks like a full (SHA1 or SHA256) object id.
+    //
+    static bool
+    object_id (const string& s)
+    {
+      if (s.size () != 40 && s.size () != 64)
+        return false;
+
+      for (char c: s)
+      {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')))
+          return false;
+      }
+
+      return true;
+    }
+
+    // Resolve HEAD to the commit id by reading the repository files directly
+    // (HEAD, loose refs, and packed-refs) rather than running git. Return
+    // empty string if there is no HEAD (new repository without any commits)
+    // and nullopt if unable to resolve (unknown repository layout, etc), in
+    // which case the caller should fall back to asking git. In both cases
+    // also set the git common directory (where the shared refs and objects
+    // are; empty if unknown).
+    //
+    static optional<string>
+    resolve_head (const dir_path& rep_root, dir_path& cd)
+    {
+      try
+      {
+        // In a submodule or a linked worktree .git is a file that refers to
+        // the actual git directory.
+        //
+        dir_path gd;
+        {
+          path f (rep_root / path (".git"));
+
+          if (file_exists (f,
+                           true /* follow_symlinks */,
+                           true /* ignore_error */))
+          {
+            optional<string> l (read_line (f));
+
+            if (!l || l->compare (0, 8, "gitdir: ") != 0)
+              return nullopt;
+
+            gd = dir_path (string (*l, 8));
+
+            if (gd.relative ())
+              gd = rep_root / gd;
+          }
+          else
+            gd = path_cast<dir_path> (move (f));
+        }
+
+        // For a linked worktree the shared refs are in the common directory.
+        //
+        if (optional<string> l = read_line (gd / path ("commondir")))
+        {
+          cd = dir_path (move (*l));
+
+          if (cd.relative ())
+            cd = gd / cd;
+
+          cd.normalize ();
+        }
+        else
+          cd = gd;
+
+        // We don't handle the reftable refs storage.
+        //
+        if (dir_exists (cd / dir_path ("reftable"), true /* ignore_error */))
+          return nullopt;
+
+        optional<string> l (read_line (gd / path ("HEAD")));
+        if (!l)
+          return nullopt;
+
+        // Follow symbolic refs (with the loop limit as a precaution).
+        //
+        for (size_t i (0); i != 10; ++i)
+        {
+          if (object_id (*l))
+            return l;
+
+          if (l->compare (0, 5, "ref: ") != 0)
+            return nullopt;
+
+          string r (*l, 5);
+
+          if (optional<string> v = read_line (cd / path (r)))
+          {
+            l = move (v);
+            continue;
+          }
+
+          // Not a loose ref, try packed-refs whose lines look like:
+          //
+          // # pack-refs with: peeled fully-peeled sorted
+          // <id> <ref>
+          // ^<peeled-id>
+          //
+          path pf (cd / path ("packed-refs"));
+          if (file_exists (pf,
+                           true /* follow_symlinks */,
+                           true /* ignore_error */))
+          {
+            ifdstream is (pf, ifdstream::badbit);
+
+            for (string pl; !eof (getline (is, pl)); )
+            {
+              size_t p (pl.find (' '));
+
+              if (p != string::npos &&
+                  pl.compare (p + 1, string::npos, r) == 0)
+              {
+                pl.resize (p);
+
+                if (!object_id (pl))
+                  return nullopt;
+
+                return pl;
+              }
+            }
+
+            is.close ();
+          }
+
+          return string (); // Unborn branch.
+        }
+      }
+      catch (const invalid_path&) {}
+      catch (const io_error&) {}
+      catch (const system_error&) {}
+
+      return nullopt;
+    }
+
     snapshot
-    extract_snapshot_git (context& ctx, dir_path rep_root)
+    extract_snapshot_git (context& ctx, dir_path rep_root, bool disk_cache)
     {
+      tracer trace ("version::extract_snapshot_git");
+
       if (const snapshot* r = cache.find (rep_root))
         return *r;
 
@@ -92,9 +256,68 @@ namespace build2
         args,
         [](string& s, bool) {return move (s);}).empty ();
 
-      // Now extract the commit id and date. One might think that would be
-      // easy... Commit id is a SHA1 hash of the commit object. And commit
-      // object looks like this:
+      // Now extract the commit id and date.
+      //
+      // First try to resolve HEAD ourselves. If that succeeds, then we can
+      // detect the new repository case (see below) without running git and,
+      // if requested, also look up the commit information in the on-disk
+      // cache. The cache is stored in the git common directory (so that it
+      // is shared between all the projects in the repository as well as
+      // between worktrees) and is keyed by the commit object id, which makes
+      // it always valid (commit objects are immutable). The cache file
+      // contains a single line in the following form:
+      //
+      // <commit-object-id> <snapshot-sn> <snapshot-id>
+      //
+      // The cache file is written to a temporary file and then moved into
+      // place so that several processes racing to update it don't see it
+      // partially written (and an invalid cache is ignored in any case).
+      //
+      dir_path cd;
+      optional<string> head (resolve_head (rep_root, cd));
+
+      if (head && head->empty ())
+      {
+        // New repository without HEAD (see below for details).
+        //
+        r.sn = 19700101000000ULL;
+        r.committed = false;
+        return cache.insert (move (rep_root), move (r));
+      }
+
+      path cf;
+      if (head && disk_cache)
+      {
+        cf = cd / path ("build2-snapshot");
+
+        if (optional<string> l = read_line (cf))
+        {
+          size_t n (head->size ());
+
+          if (l->size () == n + 1 + 14 + 1 + 12 &&
+              l->compare (0, n, *head) == 0    &&
+              (*l)[n] == ' ' && (*l)[n + 15] == ' ')
+          try
+          {
+            r.sn = stoull (string (*l, n + 1, 14));
+
+            if (r.committed)
+              r.id.assign (*l, n + 16, 12);
+            else
+              r.sn++; // Add a second (see below).
+
+            l4 ([&]{trace << "loaded snapshot for " << *head << " from "
+                          << cf;});
+
+            return cache.insert (move (rep_root), move (r));
+          }
+          catch (const invalid_argument&) {} // Fall through.
+          catch (const out_of_range&) {}
+        }
+      }
+
+      // One might think that would be easy... Commit id is a SHA1 hash of the
+      // commit object. And commit object looks like this:
       //
       // commit <len>\0
       // <data>
@@ -117,9 +340,14 @@ namespace build2
       //
       string data;
 
+      // Note that if we have resolved HEAD ourselves, then we must use the
+      // resolved commit id rather than HEAD since otherwise we could end up
+      // caching the information of a commit made in between against the
+      // previous commit id.
+      //
       args[args_i    ] = "cat-file";
       args[args_i + 1] = "commit";
-      args[args_i + 2] = "HEAD";
+      args[args_i + 2] = head ? head->c_str () : "HEAD";
       args[args_i + 3] = nullptr;
 
       process pr (run_start (3       /* verbosity */,
@@ -211,13 +439,42 @@ namespace build2
         if (r.sn == 0)
           fail << "unable to extract git commit id/date for " << rep_root;
 
-        if (r.committed)
+        sha1 cs;
+        cs.append ("commit " + to_string (data.size ())); // Includes '\0'.
+        cs.append (data.c_str (), data.size ());
+        string id (cs.string (), 0, 12); // 12-char abbreviated commit id.
+
+        // Save the commit information in the on-disk cache (see above),
+        // ignoring any errors (the repository could be read-only, etc).
+        //
+        if (!cf.empty ())
         {
-          sha1 cs;
-          cs.append ("commit " + to_string (data.size ())); // Includes '\0'.
-          cs.append (data.c_str (), data.size ());
-          r.id.assign (cs.string (), 12); // 12-char abbreviated commit id.
+          path tf (cf.string () + '.' +
+                   to_string (process::current_id ()) + ".tmp");
+          try
+          {
+            auto_rmfile rm (tf);
+            {
+              ofdstream os (tf);
+              os << *head << ' ' << r.sn << ' ' << id << '\n';
+              os.close ();
+            }
+            butl::mvfile (tf, cf, (cpflags::overwrite_content |
+                                   cpflags::overwrite_permissions));
+            rm.cancel ();
+          }
+          catch (const io_error& e)
+          {
+            l4 ([&]{trace << "unable to write " << cf << ": " << e;});
+          }
+          catch (const system_error& e)
+          {
+            l4 ([&]{trace << "unable to write " << cf << ": " << e;});
+          }
         }
+
+        if (r.committed)
+          r.id = move (id);
         else
           r.sn++; // Add a second.
       }
@@ -12,12 +12,12 @@ namespace build2
   namespace version
   {
     snapshot
-    extract_snapshot_git (context&, dir_path);
+    extract_snapshot_git (context&, dir_path, bool);
 
     static const path git (".git");
 
     snapshot
-    extract_snapshot (const scope& rs)
+    extract_snapshot (const scope& rs, bool cache)
     {
       // Resolve the path symlink components to make sure that if we are
       // extracting snapshot for a subproject which is symlinked from the git
@@ -46,7 +46,7 @@ namespace build2
         if (butl::entry_exists (d / git,
                                 true /* follow_symlinks */,
                                 true /* ignore_errors */))
-          return extract_snapshot_git (rs.ctx, move (d));
+          return extract_snapshot_git (rs.ctx, move (d), cache);
       }
 
       return snapshot ();
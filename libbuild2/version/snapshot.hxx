@@ -25,8 +25,11 @@ namespace build2
 
     // Return empty snapshot if unknown scm or uncommitted.
     //
+    // If cache is true, then also cache the commit information on disk, if
+    // supported by the scm (see config.version.snapshot_cache for details).
+    //
     snapshot
-    extract_snapshot (const scope& rs);
+    extract_snapshot (const scope& rs, bool cache);
   }
 }
 
@@ -0,0 +1,682 @@
+// file      : libbuild2/worker-pool.cxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#include <libbuild2/worker-pool.hxx>
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/un.h>
+#  include <sys/stat.h> // chmod()
+#  include <sys/socket.h>
+
+extern char** environ;
+#endif
+
+#include <cerrno>
+#include <cstring> // memcpy(), memset()
+#include <sstream>
+#include <iostream>
+
+#include <libbuild2/scheduler.hxx>
+#include <libbuild2/filesystem.hxx> // try_rmfile()
+#include <libbuild2/diagnostics.hxx>
+
+using namespace std;
+using namespace butl;
+
+namespace build2
+{
+#ifndef _WIN32
+  // Message framing (see worker_pool for the protocol description).
+  //
+  static void
+  write_all (int fd, const char* d, size_t n)
+  {
+    while (n != 0)
+    {
+      ssize_t r (::write (fd, d, n));
+
+      if (r == -1)
+      {
+        if (errno == EINTR)
+          continue;
+
+        throw_generic_ios_failure (errno);
+      }
+
+      d += r;
+      n -= static_cast<size_t> (r);
+    }
+  }
+
+  // Return false on EOF before reading anything.
+  //
+  static bool
+  read_all (int fd, char* d, size_t n)
+  {
+    for (size_t i (0); i != n; )
+    {
+      ssize_t r (::read (fd, d + i, n - i));
+
+      if (r == -1)
+      {
+        if (errno == EINTR)
+          continue;
+
+        throw_generic_ios_failure (errno);
+      }
+
+      if (r == 0)
+      {
+        if (i == 0)
+          return false;
+
+        throw_generic_ios_failure (EIO, "unexpected EOF");
+      }
+
+      i += static_cast<size_t> (r);
+    }
+
+    return true;
+  }
+
+  static void
+  write_size (string& b, size_t n)
+  {
+    uint32_t v (static_cast<uint32_t> (n));
+
+    b += static_cast<char> ((v >> 24) & 0xff);
+    b += static_cast<char> ((v >> 16) & 0xff);
+    b += static_cast<char> ((v >>  8) & 0xff);
+    b += static_cast<char> ( v        & 0xff);
+  }
+
+  static bool
+  read_size (int fd, size_t& n)
+  {
+    unsigned char b[4];
+    if (!read_all (fd, reinterpret_cast<char*> (b), 4))
+      return false;
+
+    n = (static_cast<size_t> (b[0]) << 24) |
+        (static_cast<size_t> (b[1]) << 16) |
+        (static_cast<size_t> (b[2]) <<  8) |
+         static_cast<size_t> (b[3]);
+    return true;
+  }
+
+  static void
+  write_message (int fd, const strings& m)
+  {
+    size_t n (4);
+    for (const string& f: m)
+      n += 4 + f.size ();
+
+    string b;
+    b.reserve (n);
+
+    write_size (b, m.size ());
+    for (const string& f: m)
+    {
+      write_size (b, f.size ());
+      b += f;
+    }
+
+    write_all (fd, b.data (), b.size ());
+  }
+
+  // Return false on EOF before the message.
+  //
+  static bool
+  read_message (int fd, strings& m)
+  {
+    m.clear ();
+
+    size_t n;
+    if (!read_size (fd, n))
+      return false;
+
+    m.reserve (n);
+    for (size_t i (0); i != n; ++i)
+    {
+      size_t s;
+      if (!read_size (fd, s))
+        throw_generic_ios_failure (EIO, "unexpected EOF");
+
+      string f (s, '\0');
+      if (s != 0 && !read_all (fd, &f[0], s))
+        throw_generic_ios_failure (EIO, "unexpected EOF");
+
+      m.push_back (move (f));
+    }
+
+    return true;
+  }
+
+  // Create a stream socket or accept a connection making sure the
+  // descriptor is not inherited by the child processes. Return -1 on error.
+  //
+  // Note that setting FD_CLOEXEC after the fact leaves a window where a
+  // process started by another thread could inherit the descriptor which
+  // would keep the connection open (and the peer waiting for EOF) until this
+  // process exits. So we do it atomically where supported (everywhere except
+  // Mac OS, currently).
+  //
+#ifndef SOCK_CLOEXEC
+  static int
+  cloexec (int fd)
+  {
+    if (fd != -1 && fcntl (fd, F_SETFD, FD_CLOEXEC) == -1)
+    {
+      int e (errno);
+      ::close (fd);
+      errno = e;
+      return -1;
+    }
+
+    return fd;
+  }
+#endif
+
+  static int
+  stream_socket ()
+  {
+#ifdef SOCK_CLOEXEC
+    return ::socket (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+#else
+    return cloexec (::socket (AF_UNIX, SOCK_STREAM, 0));
+#endif
+  }
+
+  static int
+  accept_connection (int fd)
+  {
+#ifdef SOCK_CLOEXEC
+    return ::accept4 (fd, nullptr, nullptr, SOCK_CLOEXEC);
+#else
+    return cloexec (::accept (fd, nullptr, nullptr));
+#endif
+  }
+
+  // Return the variable name part of an environment entry (VAR=VAL or VAR).
+  //
+  static inline size_t
+  env_name_size (const char* v)
+  {
+    const char* e (strchr (v, '='));
+    return e != nullptr ? static_cast<size_t> (e - v) : strlen (v);
+  }
+
+  // Apply environment overrides in the process_env format to the list of
+  // environment variables starting at position b.
+  //
+  static void
+  apply_environment (strings& vs, size_t b, const char* const* ovs)
+  {
+    if (ovs == nullptr)
+      return;
+
+    for (; *ovs != nullptr; ++ovs)
+    {
+      const char* o (*ovs);
+      size_t n (env_name_size (o));
+
+      for (auto i (vs.begin () + b); i != vs.end (); )
+      {
+        if (env_name_size (i->c_str ()) == n && i->compare (0, n, o, n) == 0)
+          i = vs.erase (i);
+        else
+          ++i;
+      }
+
+      if (o[n] == '=')
+        vs.push_back (o);
+    }
+  }
+
+  // Append the complete environment of the process being started: our
+  // environment with the thread environment (for example, the project
+  // environment; see auto_project_env) and the specified overrides
+  // applied. We cannot send just the overrides since the daemon's own
+  // environment may differ from ours.
+  //
+  static void
+  append_environment (strings& m, const char* const* env)
+  {
+    size_t b (m.size ());
+
+    for (const char* const* p (environ); *p != nullptr; ++p)
+      m.push_back (*p);
+
+    apply_environment (m, b, thread_env ());
+    apply_environment (m, b, env);
+  }
+
+  static bool
+  socket_address (const path& p, sockaddr_un& a)
+  {
+    const string& s (p.string ());
+
+    if (s.size () >= sizeof (a.sun_path))
+      return false;
+
+    memset (&a, 0, sizeof (a));
+    a.sun_family = AF_UNIX;
+    memcpy (a.sun_path, s.c_str (), s.size () + 1);
+    return true;
+  }
+#endif
+
+  // worker_pool
+  //
+  worker_pool::
+  worker_pool (path s)
+      : socket_ (move (s))
+  {
+#ifdef _WIN32
+    fail << "worker pool not supported on Windows";
+#endif
+  }
+
+  worker_pool::
+  ~worker_pool ()
+  {
+#ifndef _WIN32
+    for (int fd: idle_)
+      ::close (fd);
+#endif
+  }
+
+  int worker_pool::
+  connect ()
+  {
+#ifndef _WIN32
+    {
+      mlock l (mutex_);
+
+      if (!idle_.empty ())
+      {
+        int fd (idle_.back ());
+        idle_.pop_back ();
+        return fd;
+      }
+    }
+
+    sockaddr_un a;
+    if (!socket_address (socket_, a))
+      fail << "worker pool socket path " << socket_ << " is too long";
+
+    int fd (stream_socket ());
+    if (fd == -1)
+      fail << "unable to create socket: "
+           << system_error (errno, generic_category ());
+
+    if (::connect (fd, reinterpret_cast<sockaddr*> (&a), sizeof (a)) == -1)
+    {
+      int e (errno);
+      ::close (fd);
+      fail << "unable to connect to worker pool " << socket_ << ": "
+           << system_error (e, generic_category ());
+    }
+
+    return fd;
+#else
+    return -1;
+#endif
+  }
+
+  auto worker_pool::
+  execute (scheduler& sched,
+           const process_path& pp,
+           const char* const* args,
+           const char* const* env,
+           const strings& inputs,
+           const strings& outputs) -> result
+  {
+    result r;
+
+#ifndef _WIN32
+    strings m {"exec", work.string (), pp.effect_string ()};
+
+    size_t n (0);
+    for (const char* const* p (args); *p != nullptr; ++p)
+      ++n;
+
+    m.push_back (to_string (n));
+    for (size_t i (0); i != n; ++i)
+      m.push_back (args[i]);
+
+    m.push_back (to_string (inputs.size ()));
+    m.insert (m.end (), inputs.begin (), inputs.end ());
+
+    m.push_back (to_string (outputs.size ()));
+    m.insert (m.end (), outputs.begin (), outputs.end ());
+
+    append_environment (m, env);
+
+    int fd (connect ());
+
+    // While waiting for the result this thread is not doing any work so
+    // let the scheduler know.
+    //
+    // Note that activate() throws if the scheduler is being shut down.
+    //
+    bool ok (false);
+    sched.deactivate (true /* external */);
+    try
+    {
+      write_message (fd, m);
+      ok = read_message (fd, m);
+    }
+    catch (const io_error& e)
+    {
+      ::close (fd);
+      sched.activate (true /* external */);
+
+      fail << "unable to communicate with worker pool " << socket_ << ": "
+           << e;
+    }
+
+    try
+    {
+      sched.activate (true /* external */);
+    }
+    catch (const system_error&)
+    {
+      ::close (fd);
+      throw;
+    }
+
+    if (!ok)
+    {
+      ::close (fd);
+      fail << "worker pool " << socket_ << " closed connection";
+    }
+
+    // Return the connection for reuse.
+    //
+    {
+      mlock l (mutex_);
+      idle_.push_back (fd);
+    }
+
+    if (m.size () == 3 && m[0] == "exit")
+    {
+      try
+      {
+        r.exit.status = stoi (m[1]);
+      }
+      catch (const std::exception&)
+      {
+        fail << "invalid exit status '" << m[1] << "' from worker pool "
+             << socket_;
+      }
+
+      r.output.assign (m[2].begin (), m[2].end ());
+    }
+    else if (m.size () == 2 && m[0] == "error")
+      fail << "unable to execute " << args[0] << " in worker pool "
+           << socket_ << ": " << m[1];
+    else
+      fail << "invalid response from worker pool " << socket_;
+#else
+    (void) sched; (void) pp; (void) args; (void) env;
+    (void) inputs; (void) outputs;
+#endif
+
+    return r;
+  }
+
+  // worker_serve()
+  //
+#ifndef _WIN32
+  namespace
+  {
+    // Counting semaphore limiting the number of concurrently running jobs.
+    //
+    struct job_slots
+    {
+      mutex m;
+      condition_variable cv;
+      size_t free;
+
+      void
+      acquire ()
+      {
+        mlock l (m);
+        cv.wait (l, [this] {return free != 0;});
+        --free;
+      }
+
+      void
+      release ()
+      {
+        {
+          mlock l (m);
+          ++free;
+        }
+        cv.notify_one ();
+      }
+    };
+  }
+
+  // Execute the exec request returning the response.
+  //
+  static strings
+  serve_exec (const strings& m, job_slots& slots)
+  {
+    // exec <cwd> <program> <argc> <arg>... <ninputs> <input>...
+    //      <noutputs> <output>... <env>...
+    //
+    size_t i (0), n (0);
+    auto count = [&m, &i] (size_t p) -> size_t
+    {
+      size_t r (stoul (m[p]));
+      if (r > m.size () - p - 1)
+        throw invalid_argument ("count");
+      i = p + 1 + r;
+      return r;
+    };
+
+    if (m.size () < 4 || m[0] != "exec")
+      return strings {"error", "invalid request"};
+
+    cstrings args, env;
+    strings unset;
+    try
+    {
+      n = count (3);
+      for (size_t j (4); j != i; ++j)
+        args.push_back (m[j].c_str ());
+      args.push_back (nullptr);
+
+      if (i >= m.size ())
+        throw invalid_argument ("inputs");
+      count (i); // Inputs (not used locally).
+
+      if (i >= m.size ())
+        throw invalid_argument ("outputs");
+      count (i); // Outputs (not used locally).
+
+      // The request contains the complete environment so unset everything
+      // in ours that is not there.
+      //
+      for (const char* const* p (environ); *p != nullptr; ++p)
+      {
+        const char* v (*p);
+        size_t vn (env_name_size (v));
+
+        size_t j (i);
+        for (; j != m.size (); ++j)
+        {
+          if (env_name_size (m[j].c_str ()) == vn &&
+              m[j].compare (0, vn, v, vn) == 0)
+            break;
+        }
+
+        if (j == m.size ())
+          unset.emplace_back (v, vn);
+      }
+
+      for (const string& v: unset)
+        env.push_back (v.c_str ());
+
+      for (; i != m.size (); ++i)
+        env.push_back (m[i].c_str ());
+
+      env.push_back (nullptr);
+    }
+    catch (const std::exception&)
+    {
+      return strings {"error", "invalid request"};
+    }
+
+    if (n == 0)
+      return strings {"error", "no command line"};
+
+    process_path pp (run_try_search (path (m[2]), true /* init */));
+    if (pp.empty ())
+      return strings {"error", "program " + m[2] + " not found"};
+
+    const char* cwd (m[1].empty () ? nullptr : m[1].c_str ());
+
+    slots.acquire ();
+
+    strings r;
+    try
+    {
+      // Similar to the compile rule, redirect stdout to stderr and read the
+      // combined output.
+      //
+      process pr (pp,
+                  args.data (),
+                  -2 /* /dev/null */, 2, -1,
+                  cwd,
+                  env.data ());
+
+      string out;
+      try
+      {
+        ifdstream is (move (pr.in_efd),
+                      fdstream_mode::binary | fdstream_mode::skip,
+                      ifdstream::badbit);
+
+        char b[8192];
+        while (is.read (b, sizeof (b)) || is.gcount () != 0)
+          out.append (b, static_cast<size_t> (is.gcount ()));
+
+        is.close ();
+      }
+      catch (const io_error& e)
+      {
+        pr.wait ();
+        slots.release ();
+
+        ostringstream os;
+        os << "unable to read output: " << e;
+        return strings {"error", os.str ()};
+      }
+
+      pr.wait ();
+      r = strings {"exit", to_string (pr.exit->status), move (out)};
+    }
+    catch (const process_error& e)
+    {
+      if (e.child)
+      {
+        // Note: see run_start() for details.
+        //
+        cerr << "unable to execute " << args[0] << ": " << e << endl;
+        exit (1);
+      }
+
+      ostringstream os;
+      os << e;
+      r = strings {"error", os.str ()};
+    }
+
+    slots.release ();
+    return r;
+  }
+
+  static void
+  serve_connection (int fd, job_slots& slots)
+  {
+    try
+    {
+      for (strings m; read_message (fd, m); )
+        write_message (fd, serve_exec (m, slots));
+    }
+    catch (const io_error&)
+    {
+      // The client is gone or misbehaving. Either way, nothing we can do
+      // except dropping the connection.
+    }
+
+    ::close (fd);
+  }
+#endif
+
+  void
+  worker_serve (const path& s, size_t jobs)
+  {
+#ifndef _WIN32
+    tracer trace ("worker_serve");
+
+    sockaddr_un a;
+    if (!socket_address (s, a))
+      fail << "worker pool socket path " << s << " is too long";
+
+    int fd (stream_socket ());
+    if (fd == -1)
+      fail << "unable to create socket: "
+           << system_error (errno, generic_category ());
+
+    // Remove a stale socket, if any.
+    //
+    try
+    {
+      try_rmfile (s);
+    }
+    catch (const system_error& e)
+    {
+      fail << "unable to remove " << s << ": " << e;
+    }
+
+    // Since anyone who can connect can have us execute arbitrary commands,
+    // restrict access to the socket to the current user before starting to
+    // listen (connecting requires write permission on the socket file).
+    //
+    if (::bind (fd, reinterpret_cast<sockaddr*> (&a), sizeof (a)) == -1 ||
+        ::chmod (s.string ().c_str (), S_IRUSR | S_IWUSR) == -1    ||
+        ::listen (fd, 128) == -1)
+      fail << "unable to listen on " << s << ": "
+           << system_error (errno, generic_category ());
+
+    l5 ([&]{trace << "listening on " << s << " with " << jobs << " jobs";});
+
+    job_slots slots;
+    slots.free = jobs != 0 ? jobs : 1;
+
+    for (;;)
+    {
+      int c (accept_connection (fd));
+
+      if (c == -1)
+      {
+        if (errno == EINTR || errno == ECONNABORTED)
+          continue;
+
+        fail << "unable to accept connection on " << s << ": "
+             << system_error (errno, generic_category ());
+      }
+
+      thread (serve_connection, c, ref (slots)).detach ();
+    }
+#else
+    (void) s; (void) jobs;
+    fail << "worker pool not supported on Windows";
+#endif
+  }
+}
@@ -0,0 +1,100 @@
+// file      : libbuild2/worker-pool.hxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#ifndef LIBBUILD2_WORKER_POOL_HXX
+#define LIBBUILD2_WORKER_POOL_HXX
+
+#include <libbuild2/types.hxx>
+#include <libbuild2/forward.hxx>
+#include <libbuild2/utility.hxx>
+
+#include <libbuild2/export.hxx>
+
+namespace build2
+{
+  // Local worker pool (see the --worker-pool and --worker-serve options).
+  //
+  // A worker daemon (b --worker-serve <socket>) listens on a Unix-domain
+  // socket and executes command lines on behalf of one or more build system
+  // processes, running up to --jobs of them at a time. The client side
+  // (this class) keeps a set of connections to the daemon, one per job in
+  // flight, and the worker thread that submits a job is deactivated in the
+  // scheduler until the result arrives.
+  //
+  // The protocol is a sequence of request/response messages over a stream
+  // connection. Each message is a sequence of fields, each field being a
+  // 4-byte big-endian length followed by that many bytes, and the message
+  // starts with the 4-byte big-endian number of fields. A request has the
+  // following fields:
+  //
+  // exec <cwd> <program> <argc> <arg>... <ninputs> <input>...
+  //      <noutputs> <output>... <env>...
+  //
+  // Where <env> is the complete environment of the process (VAR=VAL), that
+  // is, the client's environment with the thread environment and the
+  // process_env overrides applied. The daemon runs the process in exactly
+  // this environment (rather than its own). A response is one of:
+  //
+  // exit <status> <output>
+  // error <message>
+  //
+  // Where <status> is the raw exit status and <output> is the combined
+  // stdout/stderr of the process. The declared inputs and outputs are not
+  // transferred (the daemon shares the filesystem with the client) but are
+  // part of the protocol so that it can later be taken over the network.
+  //
+  // Currently only supported on POSIX.
+  //
+  class LIBBUILD2_SYMEXPORT worker_pool
+  {
+  public:
+    explicit
+    worker_pool (path socket);
+
+    ~worker_pool ();
+
+    struct result
+    {
+      process_exit exit;
+      vector<char> output;
+    };
+
+    // Execute the command line on a worker deactivating the calling thread
+    // in the scheduler while waiting for the result. Fail if unable to
+    // communicate with the worker or if the worker was unable to execute
+    // the program.
+    //
+    result
+    execute (scheduler&,
+             const process_path&,
+             const char* const* args,
+             const char* const* env,
+             const strings& inputs,
+             const strings& outputs);
+
+    const path&
+    socket () const {return socket_;}
+
+    worker_pool (const worker_pool&) = delete;
+    worker_pool& operator= (const worker_pool&) = delete;
+
+  private:
+    int
+    connect ();
+
+  private:
+    path socket_;
+
+    mutex mutex_;
+    vector<int> idle_; // Idle connections.
+  };
+
+  // Run the worker daemon listening on the specified socket and executing
+  // up to the specified number of jobs at a time. Only return on error
+  // (fail) or if interrupted.
+  //
+  LIBBUILD2_SYMEXPORT void
+  worker_serve (const path& socket, size_t jobs);
+}
+
+#endif // LIBBUILD2_WORKER_POOL_HXX
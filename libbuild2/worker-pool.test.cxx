@@ -0,0 +1,141 @@
+// file      : libbuild2/worker-pool.test.cxx -*- C++ -*-
+// license   : MIT; see accompanying LICENSE file
+
+#include <chrono>
+
+#ifndef _WIN32
+#  include <sys/stat.h>
+#endif
+
+#include <libbuild2/types.hxx>
+#include <libbuild2/utility.hxx>
+
+#include <libbuild2/scheduler.hxx>
+#include <libbuild2/filesystem.hxx>
+#include <libbuild2/diagnostics.hxx>
+#include <libbuild2/worker-pool.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+
+namespace build2
+{
+  int
+  main (int, char* argv[])
+  {
+    // Fake build system driver, default verbosity.
+    //
+    init_diag (1);
+    init (nullptr, argv[0], true);
+
+#ifndef _WIN32
+    path s (path::temp_path ("build2-worker-pool"));
+
+    // Run the daemon in this process. Note that it never returns so we let
+    // the thread be terminated on exit.
+    //
+    thread ([&s] {worker_serve (s, 2);}).detach ();
+
+    // Wait for the daemon to start listening.
+    //
+    for (size_t i (0); !file_exists (s); ++i)
+    {
+      assert (i != 500);
+      this_thread::sleep_for (chrono::milliseconds (10));
+    }
+    this_thread::sleep_for (chrono::milliseconds (100));
+
+    // Only the current user should be able to connect.
+    //
+    {
+      struct stat st;
+      assert (::stat (s.string ().c_str (), &st) == 0);
+      assert ((st.st_mode & 0777) == 0600);
+    }
+
+    scheduler sched (1);
+    worker_pool wp (s);
+
+    process_path pp (run_search (path ("sh"), true /* init */));
+
+    auto exec = [&wp, &sched, &pp] (const char* cmd,
+                                    const char* const* env = nullptr)
+    {
+      const char* args[] {pp.recall_string (), "-c", cmd, nullptr};
+      return wp.execute (sched, pp, args, env, strings {}, strings {"out"});
+    };
+
+    // Exit status and the combined stdout/stderr output.
+    //
+    {
+      worker_pool::result r (exec ("echo out; echo err 1>&2; exit 3"));
+
+      assert (r.exit.normal () && r.exit.code () == 3);
+      assert (string (r.output.begin (), r.output.end ()) == "out\nerr\n");
+    }
+
+    // Environment: our own, overridden, and unset. The connection is reused
+    // for consecutive requests.
+    //
+    {
+      butl::setenv ("BUILD2_WORKER_POOL_X", "x");
+      butl::setenv ("BUILD2_WORKER_POOL_Y", "y");
+
+      const char* env[] {"BUILD2_WORKER_POOL_Y=z",
+                         "BUILD2_WORKER_POOL_X",
+                         nullptr};
+
+      worker_pool::result r (
+        exec ("echo \"$BUILD2_WORKER_POOL_X$BUILD2_WORKER_POOL_Y\"", env));
+
+      assert (r.exit.normal () && r.exit.code () == 0);
+      assert (string (r.output.begin (), r.output.end ()) == "z\n");
+
+      r = exec ("echo \"$BUILD2_WORKER_POOL_X$BUILD2_WORKER_POOL_Y\"");
+
+      assert (r.exit.normal () && r.exit.code () == 0);
+      assert (string (r.output.begin (), r.output.end ()) == "xy\n");
+    }
+
+    // Concurrent requests (the second job slot).
+    //
+    {
+      worker_pool::result r1, r2;
+      thread t ([&exec, &r1] {r1 = exec ("sleep 1; echo 1");});
+      r2 = exec ("echo 2");
+      t.join ();
+
+      assert (string (r1.output.begin (), r1.output.end ()) == "1\n");
+      assert (string (r2.output.begin (), r2.output.end ()) == "2\n");
+    }
+
+    // Program that cannot be found by the daemon.
+    //
+    {
+      const char* n ("build2-worker-pool-no-such-program");
+
+      process_path np (n);
+      const char* args[] {n, nullptr};
+
+      try
+      {
+        wp.execute (sched, np, args, nullptr, strings {}, strings {});
+        assert (false);
+      }
+      catch (const failed&) {}
+    }
+
+    try_rmfile (s);
+#endif
+
+    return 0;
+  }
+}
+
+int
+main (int argc, char* argv[])
+{
+  return build2::main (argc, argv);
+}